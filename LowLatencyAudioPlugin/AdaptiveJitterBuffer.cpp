@@ -0,0 +1,165 @@
+#include "AdaptiveJitterBuffer.h"
+#include <cmath>
+
+void AdaptiveJitterBuffer::prepare(double newSampleRate, int maximumBlockSize, int ringCapacity)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    
+    // O alvo nunca passa de 3/4 do ring, para sobrar espaço para o jitter do produtor
+    const int capacity = ringCapacity > 0 ? ringCapacity : AudioSharedData::defaultCapacityFrames;
+    maxTargetFrames = juce::jmax(maxBlockSize + minimumMarginFrames, capacity * 3 / 4);
+    
+    // Pior caso de entrada por callback: um bloco na razão máxima, mais a amostra extra do reamostrador
+    const int maxInputFrames = static_cast<int>(std::ceil(maxBlockSize * (1.0 + maxCorrection))) + 2;
+    scratch.setSize(AudioSharedData::maxChannels, maxInputFrames);
+    interpolators.resize(AudioSharedData::maxChannels);
+    
+    reset();
+}
+
+void AdaptiveJitterBuffer::reset()
+{
+    for (auto& interpolator : interpolators)
+        interpolator.reset();
+    
+    primed = false;
+    smoothedFill = 0.0;
+    integral = 0.0;
+    jitterPeak = 0.0;
+    target = static_cast<double>(maxBlockSize + minimumMarginFrames);
+    ratio = 1.0;
+    
+    publishedTarget.store(target, std::memory_order_relaxed);
+    publishedFill.store(0.0, std::memory_order_relaxed);
+    publishedRatio.store(1.0, std::memory_order_relaxed);
+}
+
+void AdaptiveJitterBuffer::updateTarget(int queuedFrames, int numSamples, double blockSeconds)
+{
+    // Detector de pico do desvio do nível: sobe imediatamente, desce devagar
+    const double deviation = std::abs(static_cast<double>(queuedFrames) - smoothedFill);
+    jitterPeak = juce::jmax(deviation, jitterPeak * std::exp(-blockSeconds / jitterReleaseSeconds));
+    
+    // Alvo: o bloco consumido neste callback mais a margem que o jitter observado exige
+    const double desired = numSamples + jitterSafetyFactor * jitterPeak + minimumMarginFrames;
+    target = juce::jlimit(static_cast<double>(numSamples + minimumMarginFrames),
+                          static_cast<double>(maxTargetFrames), desired);
+}
+
+void AdaptiveJitterBuffer::skipFrames(SharedMemoryManager& sharedMemory, int numFrames)
+{
+    sharedMemory.skipFrames(numFrames);
+    
+    for (auto& interpolator : interpolators)
+        interpolator.reset();
+}
+
+int AdaptiveJitterBuffer::process(SharedMemoryManager& sharedMemory, juce::AudioBuffer<float>& buffer,
+                                  int numSamples, SharedMemoryManager::ReadTiming& timing)
+{
+    numSamples = juce::jmin(numSamples, maxBlockSize);
+    timing.numFrames = 0;
+    timing.numStamps = 0;
+    
+    if (numSamples <= 0 || interpolators.empty())
+        return 0;
+    
+    const double blockSeconds = numSamples / sampleRate;
+    const int maxInputFrames = scratch.getNumSamples();
+    
+    auto region = sharedMemory.beginRead(maxInputFrames);
+    const int queued = region.queuedFrames;
+    
+    if (primed)
+        updateTarget(queued, numSamples, blockSeconds);
+    
+    if (!primed)
+    {
+        // Encher até o alvo antes de tocar (início ou depois de um underrun)
+        if (queued < target)
+        {
+            sharedMemory.commitRead(0);
+            publishedFill.store(queued, std::memory_order_relaxed);
+            return 0;
+        }
+        
+        primed = true;
+        smoothedFill = queued;
+        integral = 0.0;
+    }
+    else if (queued > 2.0 * target + maxInputFrames)
+    {
+        // Muito acima do alvo (ex.: o plugin ficou parado e o produtor não): descartar o
+        // excesso de uma vez em vez de esperar o controlador drenar a 1000 ppm
+        sharedMemory.commitRead(0);
+        skipFrames(sharedMemory, queued - static_cast<int>(target));
+        region = sharedMemory.beginRead(maxInputFrames);
+        smoothedFill = target;
+        integral = 0.0;
+    }
+    
+    // Controlador PI sobre o nível filtrado. Com o laço dF/dt = -sampleRate * correção,
+    // kp = 2w / sampleRate e ki = w^2 / sampleRate dão amortecimento crítico
+    const double omega = juce::MathConstants<double>::twoPi / controlPeriodSeconds;
+    const double kp = 2.0 * omega / sampleRate;
+    const double ki = omega * omega / sampleRate;
+    
+    smoothedFill += (1.0 - std::exp(-blockSeconds / fillSmoothingSeconds)) * (region.queuedFrames - smoothedFill);
+    
+    const double error = smoothedFill - target;
+    integral = juce::jlimit(-maxCorrection / ki, maxCorrection / ki, integral + error * blockSeconds);
+    ratio = 1.0 + juce::jlimit(-maxCorrection, maxCorrection, kp * error + ki * integral);
+    
+    // Razão > 1 consome mais entrada por quadro de saída e drena o ring
+    const int inputNeeded = static_cast<int>(std::ceil(numSamples * ratio)) + 1;
+    int outputFrames = numSamples;
+    
+    if (region.numFrames < inputNeeded)
+    {
+        // Underrun: produzir o que os dados permitem, aumentar a margem e voltar a encher
+        outputFrames = juce::jmax(0, static_cast<int>((region.numFrames - 1) / ratio));
+        jitterPeak += numSamples;
+        updateTarget(static_cast<int>(smoothedFill), numSamples, 0.0);
+        primed = false;
+        underrunCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    int consumed = 0;
+    const int ringChannels = region.numChannels;
+    
+    if (outputFrames > 0)
+    {
+        const int channelsToProcess = ringChannels == 1 ? 1 : juce::jmin(ringChannels, buffer.getNumChannels());
+        
+        for (int channel = 0; channel < channelsToProcess; ++channel)
+        {
+            // A região pode dar a volta no ring: juntar os dois trechos antes de reamostrar
+            float* input = scratch.getWritePointer(channel);
+            juce::FloatVectorOperations::copy(input, region.first[channel], region.firstSize);
+            juce::FloatVectorOperations::copy(input + region.firstSize, region.second[channel], region.secondSize);
+            
+            consumed = interpolators[static_cast<size_t>(channel)].process(ratio, input, buffer.getWritePointer(channel),
+                                                                           outputFrames, region.numFrames, 0);
+        }
+        
+        for (int channel = channelsToProcess; channel < buffer.getNumChannels(); ++channel)
+        {
+            if (ringChannels == 1)
+                buffer.copyFrom(channel, 0, buffer, 0, 0, outputFrames);
+            else
+                buffer.clear(channel, 0, outputFrames);
+        }
+    }
+    
+    sharedMemory.commitRead(consumed);
+    
+    timing = region.timing;
+    timing.numFrames = consumed;
+    
+    publishedTarget.store(target, std::memory_order_relaxed);
+    publishedFill.store(smoothedFill, std::memory_order_relaxed);
+    publishedRatio.store(ratio, std::memory_order_relaxed);
+    
+    return outputFrames;
+}
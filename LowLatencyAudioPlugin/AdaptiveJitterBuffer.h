@@ -0,0 +1,79 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "SharedMemoryManager.h"
+#include <atomic>
+#include <vector>
+
+// Buffer de jitter adaptativo com compensação de deriva de relógio
+//
+// Usado quando o gerador segue o próprio relógio (modo free-running): o host
+// consome no relógio da interface de áudio e o gerador produz no relógio do
+// sistema, então sem correção o nível do ring deriva até estourar ou esvaziar.
+// A cada callback o buffer mede o nível do ring, filtra a medida e um
+// controlador PI ajusta a razão de um reamostrador assíncrono (sinc com janela)
+// em no máximo ±maxCorrection, mantendo o nível no alvo. O termo integral
+// converge para a razão entre os dois relógios.
+//
+// O alvo acompanha o jitter observado: o desvio do nível em relação à média é
+// seguido por um detector de pico que sobe na hora e desce devagar, e cada
+// underrun aumenta a margem. No início e depois de um underrun o buffer volta a
+// encher até o alvo antes de tocar.
+class AdaptiveJitterBuffer
+{
+public:
+    AdaptiveJitterBuffer() = default;
+    
+    // Aloca tudo o que process usa (chamar fora da thread de áudio)
+    void prepare(double newSampleRate, int maximumBlockSize, int ringCapacity);
+    
+    // Volta ao estado inicial sem alocar (pode ser chamado na thread de áudio)
+    void reset();
+    
+    // Lê do ring e produz até numSamples quadros reamostrados no início do buffer. Retorna
+    // quantos quadros foram produzidos: menos que numSamples em underrun e 0 enquanto o
+    // buffer enche até o alvo. O mapeamento de canais é o mesmo de readAudioData. timing
+    // recebe os carimbos dos quadros de entrada consumidos
+    int process(SharedMemoryManager& sharedMemory, juce::AudioBuffer<float>& buffer, int numSamples,
+                SharedMemoryManager::ReadTiming& timing);
+    
+    // Estado do controlador (qualquer thread)
+    double getTargetFill() const { return publishedTarget.load(std::memory_order_relaxed); }   // quadros
+    double getFillLevel() const { return publishedFill.load(std::memory_order_relaxed); }      // quadros
+    double getRatio() const { return publishedRatio.load(std::memory_order_relaxed); }
+    int getUnderrunCount() const { return underrunCount.load(std::memory_order_relaxed); }
+    static int getResamplerLatency() { return static_cast<int>(juce::WindowedSincInterpolator::getBaseLatency()); }
+
+private:
+    void updateTarget(int queuedFrames, int numSamples, double blockSeconds);
+    void skipFrames(SharedMemoryManager& sharedMemory, int numFrames);
+    
+    static constexpr double maxCorrection = 0.001;          // ±1000 ppm (menos de 2 cents)
+    static constexpr double controlPeriodSeconds = 20.0;    // período natural do laço PI (amortecimento crítico)
+    static constexpr double fillSmoothingSeconds = 0.5;     // filtro da medida de nível
+    static constexpr double jitterReleaseSeconds = 30.0;    // queda do detector de pico do jitter
+    static constexpr double jitterSafetyFactor = 2.0;
+    static constexpr int minimumMarginFrames = 32;
+    
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+    int maxTargetFrames = 0;
+    
+    std::vector<juce::WindowedSincInterpolator> interpolators;
+    juce::AudioBuffer<float> scratch;   // região lida do ring, contígua por canal
+    
+    // Estado do controlador (somente a thread de áudio)
+    bool primed = false;
+    double smoothedFill = 0.0;
+    double integral = 0.0;
+    double jitterPeak = 0.0;
+    double target = 0.0;
+    double ratio = 1.0;
+    
+    std::atomic<double> publishedTarget { 0.0 };
+    std::atomic<double> publishedFill { 0.0 };
+    std::atomic<double> publishedRatio { 1.0 };
+    std::atomic<int> underrunCount { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AdaptiveJitterBuffer)
+};
@@ -0,0 +1,433 @@
+#include "LowLatencyAudioPlugin.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// Medição de ponta a ponta da ponte, entre processos (Linux)
+//
+// O BridgeHarness faz o papel de um host sem interface: abre o gerador
+// (SineWaveGenerator --run) como processo filho, cria o LowLatencyAudioProcessor e
+// chama processBlock em uma thread com relógio periódico absoluto (clock_nanosleep
+// com TIMER_ABSTIME), na taxa e no tamanho de bloco pedidos, por N minutos, com
+// threads de carga disputando a CPU se pedido. Ao final relata:
+//
+//   - atraso do despertar e duração de cada callback (percentis)
+//   - xruns do host: callbacks que terminaram depois do prazo (o início do seguinte)
+//   - contadores do stream no período (underruns, overruns, quadros perdidos...)
+//   - a idade das amostras tocadas (LatencyMonitor: publicação do bloco pelo gerador
+//     até a posição da amostra no bloco do host), com p50, p99 e p99,9
+//   - o tempo de CPU da thread de áudio e do processo do gerador
+//
+// Usa o segmento padrão e o stream 1, como o plugin num host: não rodar com outro
+// gerador já publicando nesse stream.
+
+// Opções de linha de comando
+struct HarnessOptions {
+    double sampleRate = 48000.0;
+    int blockSize = 128;
+    double minutes = 1.0;
+    int loadThreads = 0;                // threads de carga (memcpy e ponto flutuante sem pausa)
+    int fifoPriority = 0;               // prioridade SCHED_FIFO da thread de áudio (0 = política normal)
+    juce::File generator;
+    juce::StringArray generatorArguments;
+    bool json = false;
+    bool failOnXrun = false;
+};
+
+// O que a thread de áudio simulada mediu
+struct HostResult {
+    std::vector<uint64_t> latenessNs;   // despertar real menos o instante agendado
+    std::vector<uint64_t> durationNs;   // duração de processBlock
+    juce::int64 callbacks = 0;
+    juce::int64 xruns = 0;
+    juce::int64 skippedPeriods = 0;     // períodos inteiros sem callback depois de um xrun
+    uint64_t elapsedNs = 0;
+    uint64_t cpuNs = 0;
+    bool realtime = false;
+};
+
+static constexpr int generatorStartSeconds = 5;     // prazo para o gerador publicar o stream
+
+static uint64_t getThreadCpuNanoseconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+static void sleepUntil(uint64_t deadlineNs)
+{
+    // Mesmo relógio de SharedMemoryManager::getMonotonicNanoseconds
+    timespec deadline {};
+    deadline.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+    
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+    {
+    }
+}
+
+// Carga de CPU e de memória: copia 4 MB de um lado para o outro e mistura as amostras
+static void runLoad(const std::atomic<bool>& stopRequested)
+{
+    std::vector<float> source(1 << 20, 0.5f);
+    std::vector<float> destination(source.size());
+    float accumulator = 0.0f;
+    
+    while (!stopRequested.load(std::memory_order_relaxed))
+    {
+        std::memcpy(destination.data(), source.data(), source.size() * sizeof(float));
+        
+        for (size_t i = 0; i < source.size(); i += 16)
+            accumulator = accumulator * 0.999f + std::sqrt(destination[i] + 1.0f);
+        
+        source.swap(destination);
+    }
+    
+    juce::ignoreUnused(accumulator);
+}
+
+// Thread de áudio simulada: processBlock a cada período, no instante absoluto agendado
+static void runHost(LowLatencyAudioProcessor& processor, const HarnessOptions& options, HostResult& result)
+{
+    if (options.fifoPriority > 0)
+    {
+        sched_param parameters {};
+        parameters.sched_priority = options.fifoPriority;
+        result.realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+    }
+    
+    const double periodNs = options.blockSize * 1.0e9 / options.sampleRate;
+    const auto totalCallbacks = static_cast<juce::int64>(std::ceil(options.minutes * 60.0 * options.sampleRate / options.blockSize));
+    
+    // Tudo reservado antes do primeiro callback: o laço não aloca
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), options.blockSize);
+    juce::MidiBuffer midi;
+    result.latenessNs.reserve(static_cast<size_t>(totalCallbacks));
+    result.durationNs.reserve(static_cast<size_t>(totalCallbacks));
+    
+    const uint64_t cpuStartNs = getThreadCpuNanoseconds();
+    const uint64_t startNs = SharedMemoryManager::getMonotonicNanoseconds() + static_cast<uint64_t>(periodNs);
+    juce::int64 period = 0;
+    
+    while (period < totalCallbacks)
+    {
+        const uint64_t wakeNs = startNs + static_cast<uint64_t>(std::llround(static_cast<double>(period) * periodNs));
+        sleepUntil(wakeNs);
+        
+        const uint64_t beginNs = SharedMemoryManager::getMonotonicNanoseconds();
+        buffer.clear();
+        processor.processBlock(buffer, midi);
+        const uint64_t endNs = SharedMemoryManager::getMonotonicNanoseconds();
+        
+        result.latenessNs.push_back(beginNs > wakeNs ? beginNs - wakeNs : 0);
+        result.durationNs.push_back(endNs - beginNs);
+        ++result.callbacks;
+        
+        // O bloco devia estar pronto no início do período seguinte
+        const uint64_t deadlineNs = wakeNs + static_cast<uint64_t>(periodNs);
+        ++period;
+        
+        if (endNs > deadlineNs)
+        {
+            ++result.xruns;
+            
+            // Como um driver, retomar no próximo período ainda por vir, sem tentar recuperar os perdidos
+            const auto nextPeriod = static_cast<juce::int64>(std::ceil(static_cast<double>(endNs - startNs) / periodNs));
+            result.skippedPeriods += juce::jmax(static_cast<juce::int64>(0), nextPeriod - period);
+            period = juce::jmax(period, nextPeriod);
+        }
+    }
+    
+    result.elapsedNs = SharedMemoryManager::getMonotonicNanoseconds() - startNs;
+    result.cpuNs = getThreadCpuNanoseconds() - cpuStartNs;
+}
+
+static double percentileUs(std::vector<uint64_t>& values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    
+    const size_t index = juce::jmin(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return static_cast<double>(values[index]) / 1000.0;
+}
+
+static double maxUs(const std::vector<uint64_t>& values)
+{
+    return values.empty() ? 0.0 : static_cast<double>(*std::max_element(values.begin(), values.end())) / 1000.0;
+}
+
+static double getChildrenCpuSeconds()
+{
+    rusage usage {};
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+         + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1.0e6;
+}
+
+// Medição completa; roda fora da thread de mensagens, que fica livre para o timer do processador
+static int runHarness(LowLatencyAudioProcessor& processor, const HarnessOptions& options)
+{
+    const double runSeconds = options.minutes * 60.0;
+    
+    if (processor.isGeneratorActive())
+    {
+        std::cerr << "A generator is already publishing on stream 1; stop it before running the harness" << std::endl;
+        return 1;
+    }
+    
+    // O gerador segue além da medição pelo prazo de partida, para não faltar áudio no fim
+    juce::StringArray arguments;
+    arguments.add(options.generator.getFullPathName());
+    arguments.add("--run");
+    arguments.add(juce::String(runSeconds + generatorStartSeconds, 1));
+    arguments.addArray(options.generatorArguments);
+    
+    juce::ChildProcess child;
+    const uint64_t launchNs = SharedMemoryManager::getMonotonicNanoseconds();
+    
+    if (!child.start(arguments, 0))
+    {
+        std::cerr << "Could not start " << options.generator.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    // O timer do processador liga-se ao stream quando o gerador o registra
+    const uint64_t startDeadline = SharedMemoryManager::getMonotonicNanoseconds() + generatorStartSeconds * 1000000000ULL;
+    
+    while (!processor.isGeneratorActive())
+    {
+        if (SharedMemoryManager::getMonotonicNanoseconds() > startDeadline || !child.isRunning())
+        {
+            std::cerr << "The generator did not become active" << std::endl;
+            child.kill();
+            return 1;
+        }
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    // prepareToPlay na thread de mensagens, como nos hosts
+    processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+    juce::MessageManager::getInstance()->callFunctionOnMessageThread([] (void* userData) -> void*
+    {
+        auto& target = *static_cast<LowLatencyAudioProcessor*>(userData);
+        target.prepareToPlay(target.getSampleRate(), target.getBlockSize());
+        return nullptr;
+    }, &processor);
+    
+    processor.togglePlayback();
+    
+    const auto countersBefore = processor.getStreamCounters();
+    const int concealmentsBefore = processor.getConcealmentCount();
+    
+    std::atomic<bool> stopLoad { false };
+    std::vector<std::thread> load;
+    
+    for (int i = 0; i < options.loadThreads; ++i)
+        load.emplace_back(runLoad, std::cref(stopLoad));
+    
+    HostResult host;
+    std::thread hostThread(runHost, std::ref(processor), std::cref(options), std::ref(host));
+    hostThread.join();
+    
+    stopLoad.store(true);
+    
+    for (auto& thread : load)
+        thread.join();
+    
+    const auto countersAfter = processor.getStreamCounters();
+    const int concealments = processor.getConcealmentCount() - concealmentsBefore;
+    const auto sampleAge = processor.getSampleAgeDistribution();
+    
+    processor.togglePlayback();
+    
+    if (!child.waitForProcessToFinish((generatorStartSeconds + 5) * 1000))
+        child.kill();
+    
+    const double generatorCpuSeconds = getChildrenCpuSeconds();
+    const double generatorSeconds = static_cast<double>(SharedMemoryManager::getMonotonicNanoseconds() - launchNs) / 1.0e9;
+    
+    const uint64_t underruns = countersAfter.underruns - countersBefore.underruns;
+    const uint64_t overruns = countersAfter.overruns - countersBefore.overruns;
+    const uint64_t droppedFrames = countersAfter.droppedFrames - countersBefore.droppedFrames;
+    const uint64_t lostFrames = countersAfter.lostFrames - countersBefore.lostFrames;
+    const uint64_t repeatedFrames = countersAfter.repeatedFrames - countersBefore.repeatedFrames;
+    const uint64_t concealedFrames = countersAfter.concealedFrames - countersBefore.concealedFrames;
+    
+    const double elapsedSeconds = static_cast<double>(host.elapsedNs) / 1.0e9;
+    const double hostCpuPercent = host.elapsedNs > 0 ? 100.0 * static_cast<double>(host.cpuNs) / static_cast<double>(host.elapsedNs) : 0.0;
+    const double generatorCpuPercent = 100.0 * generatorCpuSeconds / generatorSeconds;
+    
+    const double latenessP50 = percentileUs(host.latenessNs, 0.5);
+    const double latenessP99 = percentileUs(host.latenessNs, 0.99);
+    const double latenessP999 = percentileUs(host.latenessNs, 0.999);
+    const double durationP50 = percentileUs(host.durationNs, 0.5);
+    const double durationP99 = percentileUs(host.durationNs, 0.99);
+    const double durationP999 = percentileUs(host.durationNs, 0.999);
+    
+    if (options.json)
+    {
+        std::cout << "{\"sampleRate\":" << options.sampleRate
+                  << ",\"blockSize\":" << options.blockSize
+                  << ",\"seconds\":" << elapsedSeconds
+                  << ",\"loadThreads\":" << options.loadThreads
+                  << ",\"realtime\":" << (host.realtime ? "true" : "false")
+                  << ",\"callbacks\":" << host.callbacks
+                  << ",\"hostXruns\":" << host.xruns
+                  << ",\"skippedPeriods\":" << host.skippedPeriods
+                  << ",\"latenessUs\":{\"p50\":" << latenessP50 << ",\"p99\":" << latenessP99
+                  << ",\"p999\":" << latenessP999 << ",\"max\":" << maxUs(host.latenessNs) << "}"
+                  << ",\"callbackUs\":{\"p50\":" << durationP50 << ",\"p99\":" << durationP99
+                  << ",\"p999\":" << durationP999 << ",\"max\":" << maxUs(host.durationNs) << "}"
+                  << ",\"sampleAgeMs\":{\"min\":" << sampleAge.minMs << ",\"mean\":" << sampleAge.meanMs
+                  << ",\"p50\":" << sampleAge.p50Ms << ",\"p99\":" << sampleAge.p99Ms
+                  << ",\"p999\":" << sampleAge.p999Ms << ",\"max\":" << sampleAge.maxMs
+                  << ",\"samples\":" << sampleAge.numSamples << "}"
+                  << ",\"bridge\":{\"underruns\":" << underruns << ",\"overruns\":" << overruns
+                  << ",\"droppedFrames\":" << droppedFrames << ",\"lostFrames\":" << lostFrames
+                  << ",\"repeatedFrames\":" << repeatedFrames << ",\"concealedFrames\":" << concealedFrames
+                  << ",\"concealments\":" << concealments << "}"
+                  << ",\"cpuPercent\":{\"host\":" << hostCpuPercent << ",\"generator\":" << generatorCpuPercent << "}}"
+                  << std::endl;
+    }
+    else
+    {
+        std::cout << std::fixed << std::setprecision(1)
+                  << "BridgeHarness: " << options.sampleRate << " Hz, " << options.blockSize << " frames, "
+                  << elapsedSeconds << " s, " << options.loadThreads << " load threads, "
+                  << (host.realtime ? "SCHED_FIFO " + std::to_string(options.fifoPriority) : std::string("SCHED_OTHER")) << "\n"
+                  << "  callbacks        " << host.callbacks << " (" << host.xruns << " host xruns, "
+                  << host.skippedPeriods << " skipped periods)\n"
+                  << "  wake-up late     p50 " << latenessP50 << "  p99 " << latenessP99 << "  p99.9 " << latenessP999
+                  << "  max " << maxUs(host.latenessNs) << " us\n"
+                  << "  processBlock     p50 " << durationP50 << "  p99 " << durationP99 << "  p99.9 " << durationP999
+                  << "  max " << maxUs(host.durationNs) << " us\n"
+                  << std::setprecision(3)
+                  << "  sample age       min " << sampleAge.minMs << "  mean " << sampleAge.meanMs
+                  << "  p50 " << sampleAge.p50Ms << "  p99 " << sampleAge.p99Ms << "  p99.9 " << sampleAge.p999Ms
+                  << "  max " << sampleAge.maxMs << " ms\n"
+                  << "  bridge           " << underruns << " underruns, " << overruns << " overruns, "
+                  << droppedFrames << " dropped, " << lostFrames << " lost, " << repeatedFrames << " repeated, "
+                  << concealedFrames << " concealed frames (" << concealments << " concealments)\n"
+                  << std::setprecision(1)
+                  << "  cpu              host audio thread " << hostCpuPercent << "%, generator " << generatorCpuPercent << "%"
+                  << std::defaultfloat << std::endl;
+    }
+    
+    if (options.fifoPriority > 0 && !host.realtime)
+        std::cerr << "SCHED_FIFO was refused (needs CAP_SYS_NICE or an rtprio limit); ran with the normal policy" << std::endl;
+    
+    if (options.failOnXrun && (host.xruns > 0 || underruns > 0 || overruns > 0))
+        return 1;
+    
+    return 0;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: BridgeHarness [options] [--generator-arg <arg>]...\n"
+              << "  --rate <hz>             Host sample rate (default 48000)\n"
+              << "  --block <frames>        Host block size (default 128)\n"
+              << "  --minutes <m>           Length of the run (default 1)\n"
+              << "  --load <threads>        Busy threads competing for the CPU during the run (default 0)\n"
+              << "  --fifo <priority>       Run the host audio thread with SCHED_FIFO at this priority\n"
+              << "  --generator <path>      SineWaveGenerator executable (default: next to this program)\n"
+              << "  --generator-arg <arg>   Extra generator argument, e.g. --pull or --free-run (repeatable)\n"
+              << "  --json                  One JSON object instead of the report\n"
+              << "  --fail-on-xrun          Exit with status 1 after any host xrun, underrun or overrun" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    HarnessOptions options;
+    options.generator = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getSiblingFile("SineWaveGenerator");
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        
+        if (arg == "--rate" && i + 1 < argc)
+        {
+            options.sampleRate = juce::jlimit(8000.0, 384000.0, std::atof(argv[++i]));
+        }
+        else if (arg == "--block" && i + 1 < argc)
+        {
+            options.blockSize = juce::jlimit(16, 8192, std::atoi(argv[++i]));
+        }
+        else if (arg == "--minutes" && i + 1 < argc)
+        {
+            options.minutes = juce::jmax(0.01, std::atof(argv[++i]));
+        }
+        else if (arg == "--load" && i + 1 < argc)
+        {
+            options.loadThreads = juce::jlimit(0, 256, std::atoi(argv[++i]));
+        }
+        else if (arg == "--fifo" && i + 1 < argc)
+        {
+            options.fifoPriority = juce::jlimit(0, 99, std::atoi(argv[++i]));
+        }
+        else if (arg == "--generator" && i + 1 < argc)
+        {
+            options.generator = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        }
+        else if (arg == "--generator-arg" && i + 1 < argc)
+        {
+            options.generatorArguments.add(argv[++i]);
+        }
+        else if (arg == "--json")
+        {
+            options.json = true;
+        }
+        else if (arg == "--fail-on-xrun")
+        {
+            options.failOnXrun = true;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    if (!options.generator.existsAsFile())
+    {
+        std::cerr << "Generator not found at " << options.generator.getFullPathName() << "; pass --generator <path>" << std::endl;
+        return 1;
+    }
+    
+    // O processador usa um timer: a thread principal vira a thread de mensagens, e a
+    // medição roda em outra, que encerra o laço de mensagens ao terminar
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    int exitCode = 1;
+    
+    {
+        LowLatencyAudioProcessor processor;
+        
+        std::thread control([&processor, &options, &exitCode]
+        {
+            exitCode = runHarness(processor, options);
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        });
+        
+        juce::MessageManager::getInstance()->runDispatchLoop();
+        control.join();
+        
+        processor.releaseResources();
+    }
+    
+    return exitCode;
+}
@@ -0,0 +1,159 @@
+#include "LatencyMonitor.h"
+#include <algorithm>
+#include <cmath>
+
+void LatencyMonitor::prepare(double newSampleRate)
+{
+    nanosecondsPerFrame = 1.0e9 / (newSampleRate > 0.0 ? newSampleRate : 44100.0);
+    histogram.assign(numBins, 0);
+    sessionHistogram.assign(numBins, 0);
+    
+    reset();
+}
+
+void LatencyMonitor::reset()
+{
+    std::fill(histogram.begin(), histogram.end(), 0u);
+    windowStartNs = 0;
+    windowCount = 0;
+    windowSumNs = 0.0;
+    windowMinNs = 0.0;
+    windowMaxNs = 0.0;
+    
+    std::fill(sessionHistogram.begin(), sessionHistogram.end(), 0u);
+    sessionCount = 0;
+    sessionSumNs = 0.0;
+    sessionMinNs = 0.0;
+    sessionMaxNs = 0.0;
+    
+    publishedCount.store(0, std::memory_order_relaxed);
+}
+
+void LatencyMonitor::record(const SharedMemoryManager::ReadTiming& timing, double outputFramesPerInputFrame,
+                            int extraDelayFrames)
+{
+    if (histogram.empty() || timing.numFrames <= 0)
+        return;
+    
+    if (windowStartNs == 0)
+        windowStartNs = timing.readTimeNs;
+    
+    const uint64_t endIndex = timing.startIndex + static_cast<uint64_t>(timing.numFrames);
+    const double stepNs = outputFramesPerInputFrame * nanosecondsPerFrame;
+    
+    for (int i = 0; i < timing.numStamps; ++i)
+    {
+        const auto& stamp = timing.stamps[i];
+        const uint64_t first = std::max(stamp.startIndex, timing.startIndex);
+        const uint64_t last = std::min(stamp.startIndex + static_cast<uint64_t>(stamp.numFrames), endIndex);
+        
+        if (first >= last)
+            continue;
+        
+        // A idade cresce linearmente dentro do trecho: a primeira amostra dele toca na posição
+        // (first - startIndex) do bloco do host, a seguinte um passo depois
+        const double position = static_cast<double>(first - timing.startIndex) * outputFramesPerInputFrame + extraDelayFrames;
+        double ageNs = static_cast<double>(timing.readTimeNs) + position * nanosecondsPerFrame
+                     - static_cast<double>(stamp.timestampNs);
+        
+        for (uint64_t index = first; index < last; ++index, ageNs += stepNs)
+        {
+            const double age = std::max(0.0, ageNs);
+            const int bin = std::min(numBins - 1, static_cast<int>(age / binWidthNs));
+            ++histogram[static_cast<size_t>(bin)];
+            
+            windowMinNs = windowCount == 0 ? age : std::min(windowMinNs, age);
+            windowMaxNs = std::max(windowMaxNs, age);
+            windowSumNs += age;
+            ++windowCount;
+        }
+    }
+    
+    if (static_cast<double>(timing.readTimeNs - windowStartNs) >= windowSeconds * 1.0e9)
+    {
+        publishWindow();
+        windowStartNs = timing.readTimeNs;
+    }
+}
+
+// Primeira faixa em que o acumulado alcança a fração pedida das amostras (limite superior da faixa)
+double LatencyMonitor::getPercentileNs(const std::vector<uint64_t>& bins, juce::int64 count, double fraction, double maxNs)
+{
+    const auto threshold = static_cast<uint64_t>(std::ceil(static_cast<double>(count) * fraction));
+    uint64_t accumulated = 0;
+    int bin = 0;
+    
+    for (; bin < numBins - 1; ++bin)
+    {
+        accumulated += bins[static_cast<size_t>(bin)];
+        
+        if (accumulated >= threshold)
+            break;
+    }
+    
+    return std::min(maxNs, (bin + 1) * binWidthNs);
+}
+
+void LatencyMonitor::publishWindow()
+{
+    if (windowCount > 0)
+    {
+        const double p99Ns = getPercentileNs(histogram, windowCount, 0.99, windowMaxNs);
+        
+        // A janela entra na distribuição da sessão
+        for (size_t bin = 0; bin < histogram.size(); ++bin)
+            sessionHistogram[bin] += histogram[bin];
+        
+        sessionMinNs = sessionCount == 0 ? windowMinNs : std::min(sessionMinNs, windowMinNs);
+        sessionMaxNs = std::max(sessionMaxNs, windowMaxNs);
+        sessionSumNs += windowSumNs;
+        sessionCount += windowCount;
+        
+        publishedMinMs.store(static_cast<float>(windowMinNs * 1.0e-6), std::memory_order_relaxed);
+        publishedMeanMs.store(static_cast<float>(windowSumNs / static_cast<double>(windowCount) * 1.0e-6), std::memory_order_relaxed);
+        publishedP99Ms.store(static_cast<float>(p99Ns * 1.0e-6), std::memory_order_relaxed);
+        publishedMaxMs.store(static_cast<float>(windowMaxNs * 1.0e-6), std::memory_order_relaxed);
+    }
+    
+    publishedCount.store(windowCount, std::memory_order_relaxed);
+    
+    std::fill(histogram.begin(), histogram.end(), 0u);
+    windowCount = 0;
+    windowSumNs = 0.0;
+    windowMinNs = 0.0;
+    windowMaxNs = 0.0;
+}
+
+LatencyMonitor::Distribution LatencyMonitor::getSessionDistribution() const
+{
+    Distribution distribution;
+    distribution.numSamples = sessionCount;
+    
+    if (sessionCount > 0)
+    {
+        distribution.minMs = static_cast<float>(sessionMinNs * 1.0e-6);
+        distribution.meanMs = static_cast<float>(sessionSumNs / static_cast<double>(sessionCount) * 1.0e-6);
+        distribution.p50Ms = static_cast<float>(getPercentileNs(sessionHistogram, sessionCount, 0.5, sessionMaxNs) * 1.0e-6);
+        distribution.p99Ms = static_cast<float>(getPercentileNs(sessionHistogram, sessionCount, 0.99, sessionMaxNs) * 1.0e-6);
+        distribution.p999Ms = static_cast<float>(getPercentileNs(sessionHistogram, sessionCount, 0.999, sessionMaxNs) * 1.0e-6);
+        distribution.maxMs = static_cast<float>(sessionMaxNs * 1.0e-6);
+    }
+    
+    return distribution;
+}
+
+LatencyMonitor::Statistics LatencyMonitor::getStatistics() const
+{
+    Statistics statistics;
+    statistics.numSamples = publishedCount.load(std::memory_order_relaxed);
+    
+    if (statistics.numSamples > 0)
+    {
+        statistics.minMs = publishedMinMs.load(std::memory_order_relaxed);
+        statistics.meanMs = publishedMeanMs.load(std::memory_order_relaxed);
+        statistics.p99Ms = publishedP99Ms.load(std::memory_order_relaxed);
+        statistics.maxMs = publishedMaxMs.load(std::memory_order_relaxed);
+    }
+    
+    return statistics;
+}
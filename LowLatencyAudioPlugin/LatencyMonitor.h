@@ -0,0 +1,89 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "SharedMemoryManager.h"
+#include <atomic>
+#include <vector>
+
+// Medição da idade das amostras tocadas
+//
+// A idade de uma amostra é o tempo entre a publicação do bloco dela pelo
+// gerador (carimbo no relógio monotônico) e o momento em que ela toca: o
+// instante da leitura mais a posição dela no bloco do host. A thread de áudio
+// acumula as idades de todas as amostras em um histograma e, a cada janela,
+// publica mínimo, média, p99 e máximo.
+class LatencyMonitor
+{
+public:
+    struct Statistics {
+        float minMs = 0.0f;
+        float meanMs = 0.0f;
+        float p99Ms = 0.0f;
+        float maxMs = 0.0f;
+        juce::int64 numSamples = 0;     // amostras medidas na janela (0 = sem medida)
+    };
+    
+    // Distribuição acumulada de todas as janelas publicadas desde prepare/reset
+    struct Distribution {
+        float minMs = 0.0f;
+        float meanMs = 0.0f;
+        float p50Ms = 0.0f;
+        float p99Ms = 0.0f;
+        float p999Ms = 0.0f;
+        float maxMs = 0.0f;
+        juce::int64 numSamples = 0;
+    };
+    
+    LatencyMonitor() = default;
+    
+    // Aloca o histograma (chamar fora da thread de áudio)
+    void prepare(double newSampleRate);
+    
+    // Descarta a janela em curso e a última publicada, sem alocar
+    void reset();
+    
+    // Registra as amostras de uma leitura (thread de áudio). Atrás de um reamostrador, a
+    // amostra de entrada k toca na posição k * outputFramesPerInputFrame + extraDelayFrames
+    void record(const SharedMemoryManager::ReadTiming& timing, double outputFramesPerInputFrame = 1.0,
+                int extraDelayFrames = 0);
+    
+    // Estatísticas da última janela completa (qualquer thread)
+    Statistics getStatistics() const;
+    
+    // Distribuição da sessão inteira, até a última janela completa. Ler com a thread de
+    // áudio parada (ex.: ao final de uma medição), já que o acumulado não é atômico
+    Distribution getSessionDistribution() const;
+
+private:
+    void publishWindow();
+    static double getPercentileNs(const std::vector<uint64_t>& bins, juce::int64 count, double fraction, double maxNs);
+    
+    static constexpr double windowSeconds = 1.0;
+    static constexpr double binWidthNs = 50000.0;           // 50 µs por faixa do histograma
+    static constexpr int numBins = 4000;                    // até 200 ms; acima disso, na última faixa
+    
+    double nanosecondsPerFrame = 1.0e9 / 44100.0;
+    
+    // Janela em curso (somente a thread de áudio)
+    std::vector<uint64_t> histogram;
+    uint64_t windowStartNs = 0;
+    juce::int64 windowCount = 0;
+    double windowSumNs = 0.0;
+    double windowMinNs = 0.0;
+    double windowMaxNs = 0.0;
+    
+    // Soma das janelas publicadas (somente a thread de áudio escreve)
+    std::vector<uint64_t> sessionHistogram;
+    juce::int64 sessionCount = 0;
+    double sessionSumNs = 0.0;
+    double sessionMinNs = 0.0;
+    double sessionMaxNs = 0.0;
+    
+    std::atomic<float> publishedMinMs { 0.0f };
+    std::atomic<float> publishedMeanMs { 0.0f };
+    std::atomic<float> publishedP99Ms { 0.0f };
+    std::atomic<float> publishedMaxMs { 0.0f };
+    std::atomic<juce::int64> publishedCount { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyMonitor)
+};
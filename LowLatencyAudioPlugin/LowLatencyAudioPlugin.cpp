@@ -1,21 +1,59 @@
 #include "LowLatencyAudioPlugin.h"
 #include "LowLatencyAudioProcessorEditor.h" // Adicionar o include aqui
+#include "TraceRecorder.h"
+#include "RealtimeChecker.h"
+
+// Instâncias criadas neste processo, para separar cada uma no trace
+static std::atomic<int> instancesCreated { 0 };
 
 //==============================================================================
 LowLatencyAudioProcessor::LowLatencyAudioProcessor()
      : AudioProcessor (BusesProperties()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true))
 {
+    // Parâmetro de seleção do stream no diretório compartilhado
+    addParameter(streamParameter = new juce::AudioParameterInt(juce::ParameterID { "stream", 1 }, "Stream",
+                                                               1, AudioSharedData::defaultMaxStreams, 1));
+    
+    // Ganho de saída em dB, aplicado na própria cópia do ring para o buffer do host
+    addParameter(gainParameter = new juce::AudioParameterFloat(juce::ParameterID { "gain", 1 }, "Gain",
+                                                               juce::NormalisableRange<float>(minGainDb, 6.0f, 0.1f), 0.0f));
+    
+    // Modo de instrumentação (BRIDGE_TRACE): reservar os rings de eventos fora da thread de áudio.
+    // Os eventos desta instância saem na faixa instanceNumber
+    instanceNumber = instancesCreated.fetch_add(1, std::memory_order_relaxed) + 1;
+    BRIDGE_TRACE_INITIALISE("LowLatencyAudioPlugin");
+    
+    // Modo de verificação de tempo real (BRIDGE_RT_CHECKS)
+    BRIDGE_RT_INITIALISE();
+    
+    // Opções de mapeamento do segmento, sem interface: o plugin normalmente só abre o segmento do gerador.
+    // Travar e escolher o nó NUMA valem para o mapeamento deste processo; páginas enormes, se o plugin o criar
+    const char* lockSetting = std::getenv("BRIDGE_LOCK_SEGMENT");
+    const char* numaSetting = std::getenv("BRIDGE_NUMA_NODE");
+    const char* hugePagesSetting = std::getenv("BRIDGE_HUGE_PAGES");
+    memoryConfig.lockPages = lockSetting != nullptr && std::atoi(lockSetting) != 0;
+    memoryConfig.numaNode = numaSetting != nullptr ? std::atoi(numaSetting) : -1;
+    memoryConfig.hugePages = hugePagesSetting != nullptr && std::atoi(hugePagesSetting) != 0;
+    
     // Inicializar o gerenciador de memória compartilhada
-    if (!sharedMemory.initialize())
+    if (!sharedMemory.initialize(memoryConfig))
     {
         // Lidar com erro de inicialização
         juce::Logger::writeToLog("Falha ao inicializar a memória compartilhada");
     }
+    
+    // Conectar ao stream selecionado; o timer refaz a conexão quando o parâmetro muda
+    timerCallback();
+    startTimer(100);
 }
 
 LowLatencyAudioProcessor::~LowLatencyAudioProcessor()
 {
+    stopTimer();
+    
+    // O gravador é do processo: só a última instância a sair para a gravação e grava o trace
+    BRIDGE_TRACE_WRITE();
 }
 
 //==============================================================================
@@ -75,24 +113,37 @@ void LowLatencyAudioProcessor::changeProgramName (int index, const juce::String&
 
 void LowLatencyAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Informar a taxa de amostragem para a aplicação externa
-    sharedMemory.setSampleRate(sampleRate);
-
+    // Informar a taxa de amostragem e o tamanho de bloco para a aplicação externa
+    sharedMemory.setHostConfiguration(sampleRate, samplesPerBlock);
+    
+    // Modo pull: esperar o bloco pedido por no máximo um quarto do callback
+    const double blockDurationUs = samplesPerBlock * 1000000.0 / sampleRate;
+    sharedMemory.setPullSpinBudget(juce::jmin(maxPullSpinMicroseconds, static_cast<int>(blockDurationUs * 0.25)));
+    
+    // Buffer de jitter para geradores que seguem o próprio relógio
+    jitterBuffer.prepare(sampleRate, samplesPerBlock, sharedMemory.getCapacity());
+    jitterBufferActive.store(false);
+    
+    // Latência inicial para a compensação de atraso do host
+    reportedLatencySamples = -1;
+    updateReportedLatency();
+    
     // Preparar buffer de áudio
     audioBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
     audioBuffer.clear();
     
-    // Preparar buffer de backup
-    lastBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
-    lastBuffer.clear();
+    // Ocultação de underruns (histórico da saída)
+    concealer.prepare(sampleRate, getTotalNumOutputChannels());
+    
+    // Idade das amostras tocadas
+    latencyMonitor.prepare(sampleRate);
+    
+    // Inicializar o timestamp de dados recebidos (relógio monotônico, o mesmo dos callbacks)
+    lastDataReceivedNs = SharedMemoryManager::getMonotonicNanoseconds();
     
-    // Inicializar timestamp
-    lastTimestamp = std::chrono::high_resolution_clock::now();
-    lastDataReceived = lastTimestamp; // Inicializar o timestamp de dados recebidos
-
     // Inicializar frequência
     currentFrequency.store(sharedMemory.getFrequency());
-
+    
     // Reset do detector de timeout
     timeoutDetected.store(false);
 }
@@ -101,96 +152,149 @@ void LowLatencyAudioProcessor::releaseResources()
 {
     // Liberar recursos quando o plugin é desativado
     playing.store(false);
+    sharedMemory.setTransportPlaying(false);
 }
 
 bool LowLatencyAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    // Suportar apenas layouts estéreo ou mono
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Suportar qualquer layout de saída (mono, estéreo, surround até 7.1 ou discreto)
+    // com até o número máximo de canais que o ring compartilhado transporta
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+    
+    if (mainOutput.isDisabled() || mainOutput.size() > AudioSharedData::maxChannels)
         return false;
-
+    
     return true;
 }
 
 void LowLatencyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
-
+    
+    // Tudo o que o callback usa foi alocado em prepareToPlay: nada de alocação nem de
+    // mutex daqui em diante (verificado em builds com BRIDGE_RT_CHECKS)
+    BRIDGE_RT_SCOPE();
+    
+    // Duração do callback para a telemetria do stream, registrada em qualquer saída
+    struct CallbackTimer
+    {
+        SharedMemoryManager& sharedMemory;
+        const uint64_t startNs;
+        ~CallbackTimer() { sharedMemory.recordCallbackTime(startNs); }
+    } callbackTimer { sharedMemory, SharedMemoryManager::getMonotonicNanoseconds() };
+    
+    BRIDGE_TRACE_TRACK(instanceNumber);
+    BRIDGE_TRACE_THREAD_NAME("audio");
+    BRIDGE_TRACE_SCOPE("processBlock");
+    
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
-
+    
     // Limpar buffers não utilizados
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-
-
+    
+    
+    // Um único instantâneo do estado do gerador por callback (seqlock, sem bloqueio)
+    const auto generatorControl = sharedMemory.getGeneratorControl();
+    
     // Verificar primeiro se o gerador está ativo
-    if (!playing.load() || !sharedMemory.isGeneratorActive())
+    if (!playing.load() || !generatorControl.active)
     {
         buffer.clear();
+        
+        // Sem ocultação ao retomar: o histórico de uma sessão anterior não vale mais
+        if (hasValidData.load())
+            concealer.reset();
+        
         hasValidData.store(false);
         return;
     }
-
-    auto now = std::chrono::high_resolution_clock::now();
-    auto timeSinceLastData = std::chrono::duration_cast<std::chrono::milliseconds>(
-                             now - lastDataReceived);
+    
+    // O início do callback já foi lido para a telemetria: sem outra leitura de relógio
+    const uint64_t now = callbackTimer.startNs;
+    const uint64_t timeSinceLastDataNs = now > lastDataReceivedNs ? now - lastDataReceivedNs : 0;
     
     // Se não recebermos dados após o timeout E o gerador não estiver ativo, parar a reprodução
-    if (timeSinceLastData > dataTimeout && !sharedMemory.isGeneratorActive()) {
+    if (timeSinceLastDataNs > dataTimeoutNs && !generatorControl.active) {
         timeoutDetected.store(true);
         buffer.clear();
         hasValidData.store(false);
         return;
     }    
-
+    
     // Ler dados da memória compartilhada
-    float latency;
-    bool dataRead = sharedMemory.readAudioData(buffer, buffer.getNumSamples(), latency);
+    SharedMemoryManager::ReadTiming readTiming;
+    const int numSamples = buffer.getNumSamples();
+    
+    // Ganho constante vai direto no kernel de cópia; quando o parâmetro muda, ler sem
+    // ganho e aplicar uma rampa no bloco para não gerar clique
+    const float targetGain = juce::Decibels::decibelsToGain(gainParameter->get(), minGainDb);
+    const bool gainChanged = targetGain != lastGain;
+    const float blockGain = gainChanged ? 1.0f : targetGain;
+    int samplesRead = 0;
     
-    if (dataRead)
+    if (generatorControl.freeRunning)
     {
-        // Filtrar valores de latência extremos ou negativos
-        if (latency > 0.0f && latency < 1000.0f) {
-            currentLatency.store(latency);
+        // Gerador no próprio relógio: passar pelo buffer de jitter, que compensa a deriva
+        if (!jitterBufferActive.load())
+        {
+            jitterBuffer.reset();
+            jitterBufferActive.store(true);
         }
         
+        samplesRead = jitterBuffer.process(sharedMemory, buffer, numSamples, readTiming);
+        
+        if (samplesRead > 0 && blockGain != 1.0f)
+            buffer.applyGain(0, samplesRead, blockGain);
+        
+        // Atrás do reamostrador, cada quadro de entrada vale 1 / razão quadros de saída
+        latencyMonitor.record(readTiming, 1.0 / jitterBuffer.getRatio(), AdaptiveJitterBuffer::getResamplerLatency());
+    }
+    else
+    {
+        jitterBufferActive.store(false);
+        samplesRead = sharedMemory.readAudioData(buffer, numSamples, readTiming, blockGain);
+        latencyMonitor.record(readTiming);
+    }
+    
+    if (samplesRead > 0)
+    {
+        if (gainChanged)
+        {
+            buffer.applyGainRamp(0, samplesRead, lastGain, targetGain);
+            lastGain = targetGain;
+        }
+        
+        // Leitura parcial: completar o restante do bloco com a cauda de ocultação (e, depois
+        // de um underrun, misturar o início dos dados com ela)
+        concealer.process(buffer, samplesRead, numSamples);
+        
         // Verificar se a frequência mudou
-        float newFrequency = sharedMemory.getFrequency();
+        float newFrequency = generatorControl.frequency;
         float oldFrequency = currentFrequency.load();
         
         if (std::abs(newFrequency - oldFrequency) > 0.1f) {
             currentFrequency.store(newFrequency);
         }
         
-        // Armazenar uma cópia do buffer para reuso em caso de falha de leitura
-        if (lastBuffer.getNumChannels() != buffer.getNumChannels() || 
-            lastBuffer.getNumSamples() != buffer.getNumSamples()) {
-            lastBuffer.setSize(buffer.getNumChannels(), buffer.getNumSamples());
-        }
-        
-        for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
-            lastBuffer.copyFrom(ch, 0, buffer, ch, 0, buffer.getNumSamples());
-        }
-        
+        lastDataReceivedNs = now;
         hasValidData.store(true);
     }
     else if (hasValidData.load())
     {
         // Se não conseguimos ler novos dados, mas temos dados anteriores válidos,
-        // verificar se o gerador ainda está ativo antes de reutilizar o buffer
+        // verificar se o gerador ainda está ativo antes de ocultar a falha
         
-        if (!sharedMemory.isGeneratorActive()) {
+        if (!generatorControl.active) {
             // Se o gerador parou, limpar o buffer e não reutilizar dados antigos
             buffer.clear();
+            concealer.reset();
             hasValidData.store(false);
         } else {
-            // Caso contrário, reutilizar o último buffer
-            for (int ch = 0; ch < juce::jmin(buffer.getNumChannels(), lastBuffer.getNumChannels()); ++ch) {
-                buffer.copyFrom(ch, 0, lastBuffer, ch, 0, juce::jmin(buffer.getNumSamples(), lastBuffer.getNumSamples()));
-            }
+            // Caso contrário, continuar a cauda de ocultação (decai até o silêncio em ~20 ms)
+            concealer.process(buffer, 0, numSamples);
         }
     }
     else
@@ -198,6 +302,26 @@ void LowLatencyAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
         // Se não temos dados válidos nem histórico, silenciar a saída
         buffer.clear();
     }
+    
+    publishConcealment();
+}
+
+void LowLatencyAudioProcessor::publishConcealment()
+{
+    const int concealmentCount = concealer.getConcealmentCount();
+    const juce::int64 concealedFrames = concealer.getConcealedFrames();
+    
+    if (concealedFrames == publishedConcealedFrames)
+        return;
+    
+    BRIDGE_TRACE_INSTANT("conceal", concealedFrames - publishedConcealedFrames);
+    
+    // Cada transição de dados reais para ocultação é um underrun
+    sharedMemory.reportUnderrun(static_cast<int>(concealedFrames - publishedConcealedFrames),
+                                concealmentCount != publishedConcealmentCount);
+    
+    publishedConcealmentCount = concealmentCount;
+    publishedConcealedFrames = concealedFrames;
 }
 
 //==============================================================================
@@ -218,19 +342,115 @@ void LowLatencyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     juce::MemoryOutputStream stream(destData, true);
     stream.writeFloat(currentLatency.load());
     stream.writeBool(playing.load());
+    stream.writeInt(streamParameter->get());
+    stream.writeFloat(gainParameter->get());
 }
 
 void LowLatencyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // Restaurar estado do plugin
     juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
-    currentLatency.store(stream.readFloat());
+    stream.readFloat(); // latência do momento do salvamento; a atual é recalculada pelo timer
     playing.store(stream.readBool());
+    sharedMemory.setTransportPlaying(playing.load());
+    
+    // Estados salvos antes da seleção de stream não têm este campo
+    if (!stream.isExhausted())
+        setSelectedStream(stream.readInt());
+    
+    if (!stream.isExhausted())
+        *gainParameter = stream.readFloat();
 }
 
 void LowLatencyAudioProcessor::togglePlayback()
 {
     playing.store(!playing.load());
+    sharedMemory.setTransportPlaying(playing.load());
+}
+
+void LowLatencyAudioProcessor::setSelectedStream(int streamNumber)
+{
+    const auto& range = streamParameter->getRange();
+    const int clamped = juce::jlimit(range.getStart(), range.getEnd(), streamNumber);
+    
+    streamParameter->setValueNotifyingHost(streamParameter->convertTo0to1(static_cast<float>(clamped)));
+}
+
+void LowLatencyAudioProcessor::timerCallback()
+{
+    // Violações de tempo real registradas pela thread de áudio desde o último tick (BRIDGE_RT_CHECKS)
+    BRIDGE_RT_REPORT();
+    
+    // Tentar novamente caso a memória compartilhada não tenha sido inicializada
+    if (!sharedMemory.isInitialized() && !sharedMemory.initialize(memoryConfig))
+        return;
+    
+    // Acompanhar a latência da ponte (o nível alvo e o buffer de jitter se adaptam)
+    updateReportedLatency();
+    
+    // Trocar de stream fora da thread de áudio sempre que o parâmetro mudar
+    const int desiredStream = streamParameter->get() - 1;
+    
+    if (desiredStream == sharedMemory.getCurrentStream())
+        return;
+    
+    if (sharedMemory.attachStream(desiredStream))
+    {
+        streamBusy.store(false);
+        
+        // Informar ao gerador do novo stream a configuração do host
+        if (getSampleRate() > 0.0)
+            sharedMemory.setHostConfiguration(getSampleRate(), getBlockSize());
+        
+        sharedMemory.setTransportPlaying(playing.load());
+    }
+    else
+    {
+        // Outra instância viva já consome este stream: não continuar tocando o
+        // stream anterior e tentar de novo no próximo tick
+        sharedMemory.detachStream();
+        streamBusy.store(true);
+    }
+}
+
+int LowLatencyAudioProcessor::computeLatencySamples() const
+{
+    const auto generatorControl = sharedMemory.getGeneratorControl();
+    const int blockSize = juce::jmax(1, getBlockSize());
+    
+    if (!generatorControl.active)
+        return -1;
+    
+    // Relógio próprio: o alvo do buffer de jitter mais o atraso do reamostrador
+    if (generatorControl.freeRunning)
+        return juce::roundToInt(jitterBuffer.getTargetFill()) + AdaptiveJitterBuffer::getResamplerLatency();
+    
+    // Modo pull: o bloco pedido em um callback é tocado no seguinte
+    if (generatorControl.pullMode)
+        return blockSize;
+    
+    // Modo push: o nível médio que o gerador mantém no ring
+    return generatorControl.targetFill > 0 ? generatorControl.targetFill : blockSize;
+}
+
+void LowLatencyAudioProcessor::updateReportedLatency()
+{
+    const int latencySamples = computeLatencySamples();
+    
+    // Sem gerador, manter o último valor em vez de fazer o host recalcular a compensação
+    if (latencySamples < 0)
+        return;
+    
+    // Cada mudança faz o host realinhar as faixas: ignorar variações pequenas
+    if (reportedLatencySamples >= 0 && std::abs(latencySamples - reportedLatencySamples) < minLatencyChangeSamples)
+        return;
+    
+    reportedLatencySamples = latencySamples;
+    setLatencySamples(latencySamples);
+    
+    // O mesmo valor alimenta a interface
+    if (getSampleRate() > 0.0)
+        currentLatency.store(static_cast<float>(latencySamples * 1000.0 / getSampleRate()));
 }
 
 //==============================================================================
@@ -2,12 +2,16 @@
 
 #include "JuceHeader.h"
 #include "SharedMemoryManager.h"
+#include "AdaptiveJitterBuffer.h"
+#include "UnderrunConcealer.h"
+#include "LatencyMonitor.h"
 
 // Forward declaration
 class LowLatencyAudioProcessorEditor;
 
 //==============================================================================
-class LowLatencyAudioProcessor : public juce::AudioProcessor
+class LowLatencyAudioProcessor : public juce::AudioProcessor,
+                                 private juce::Timer
 {
 public:
     //==============================================================================
@@ -50,26 +54,80 @@ public:
     void togglePlayback();
     bool isPlaying() const { return playing.load(); }
     float getCurrentLatency() const { return currentLatency.load(); }
+    
+    // Idade das amostras tocadas (mínimo, média, p99 e máximo da última janela)
+    LatencyMonitor::Statistics getSampleAgeStatistics() const { return latencyMonitor.getStatistics(); }
+    
+    // Idade das amostras desde prepareToPlay (ler com processBlock parado, ex.: BridgeHarness)
+    LatencyMonitor::Distribution getSampleAgeDistribution() const { return latencyMonitor.getSessionDistribution(); }
+    
     float getCurrentFrequency() const { return currentFrequency.load(); }
 
     bool isGeneratorActive() const { 
         return sharedMemory.isGeneratorActive() && !timeoutDetected.load(); 
     }
+    
+    // Seleção de stream (1 a maxStreams), persistida no estado do plugin
+    int getSelectedStream() const { return streamParameter->get(); }
+    void setSelectedStream(int streamNumber);
+    int getNumSelectableStreams() const { return streamParameter->getRange().getEnd(); }
+    bool isStreamBusy() const { return streamBusy.load(); }
+    SharedMemoryManager::StreamInfo getStreamInfo(int streamNumber) const { return sharedMemory.getStreamInfo(streamNumber - 1); }
+    
+    // Buffer de jitter (ativo apenas quando o gerador segue o próprio relógio)
+    const AdaptiveJitterBuffer& getJitterBuffer() const { return jitterBuffer; }
+    bool isJitterBufferActive() const { return jitterBufferActive.load(); }
+    
+    // Ocultação de underruns
+    int getConcealmentCount() const { return concealer.getConcealmentCount(); }
+    juce::int64 getConcealedFrames() const { return concealer.getConcealedFrames(); }
+    
+    // Contadores acumulados do stream selecionado (memória compartilhada, dos dois lados)
+    SharedMemoryManager::StreamCounters getStreamCounters() const
+    {
+        return sharedMemory.getStreamCounters(sharedMemory.getCurrentStream());
+    }
+    
 private:
+    //==============================================================================
+    void timerCallback() override;
+    
+    // Latência efetiva da ponte em amostras (-1 enquanto não há gerador para medir)
+    int computeLatencySamples() const;
+    void updateReportedLatency();
+    
+    // Publica nos contadores do stream as ocultações feitas desde a última chamada (thread de áudio)
+    void publishConcealment();
+    
+
     //==============================================================================
     SharedMemoryManager sharedMemory;
+    SharedMemoryManager::Config memoryConfig;   // pré-carga, mlock, nó NUMA e páginas enormes do segmento
+    juce::AudioParameterInt* streamParameter = nullptr;
+    juce::AudioParameterFloat* gainParameter = nullptr;
+    float lastGain = 1.0f;      // ganho aplicado no último bloco (thread de áudio)
+    int instanceNumber = 0;     // ordem de criação no processo; faixa dos eventos no trace
+    AdaptiveJitterBuffer jitterBuffer;
+    std::atomic<bool> jitterBufferActive { false };
+    std::atomic<bool> streamBusy { false };
     std::atomic<bool> playing { false };
     juce::AudioBuffer<float> audioBuffer;
-    std::atomic<float> currentLatency { 0.0f };
+    std::atomic<float> currentLatency { 0.0f };   // latência reportada ao host, em ms
+    int reportedLatencySamples = -1;               // thread de mensagens
     std::atomic<float> currentFrequency { 440.0f };
-    std::chrono::high_resolution_clock::time_point lastTimestamp;
 
-    juce::AudioBuffer<float> lastBuffer;
+    UnderrunConcealer concealer;
+    int publishedConcealmentCount = 0;            // já somados aos contadores do stream (thread de áudio)
+    juce::int64 publishedConcealedFrames = 0;
+    LatencyMonitor latencyMonitor;
     std::atomic<bool> hasValidData { false };
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> lastDataReceived;
+    uint64_t lastDataReceivedNs = 0;              // relógio monotônico (thread de áudio)
     std::atomic<bool> timeoutDetected { false };
-    static constexpr std::chrono::milliseconds dataTimeout { 500 }; // 500ms de timeout
+    static constexpr uint64_t dataTimeoutNs = 500000000; // 500ms de timeout
+    static constexpr int maxPullSpinMicroseconds = 200; // espera ativa máxima por bloco em modo pull
+    static constexpr float minGainDb = -60.0f;          // abaixo disto o ganho é zero
+    static constexpr int minLatencyChangeSamples = 32;  // variações menores não são reportadas ao host
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LowLatencyAudioProcessor)
 };
\ No newline at end of file
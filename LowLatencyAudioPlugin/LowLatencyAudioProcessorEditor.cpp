@@ -24,6 +24,17 @@ LowLatencyAudioProcessorEditor::LowLatencyAudioProcessorEditor (LowLatencyAudioP
     latencyValueLabel.setJustificationType(juce::Justification::right);
     addAndMakeVisible(latencyValueLabel);
 
+    // Configurar label da idade das amostras
+    sampleAgeLabel.setText("Idade (min/med/p99/max):", juce::dontSendNotification);
+    sampleAgeLabel.setFont(juce::Font(14.0f));
+    addAndMakeVisible(sampleAgeLabel);
+    
+    // Configurar label de valor da idade das amostras
+    sampleAgeValueLabel.setText("--", juce::dontSendNotification);
+    sampleAgeValueLabel.setFont(juce::Font(14.0f));
+    sampleAgeValueLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(sampleAgeValueLabel);
+
     // Configurar label de frequência
     frequencyLabel.setText("Frequencia:", juce::dontSendNotification);
     frequencyLabel.setFont(juce::Font(14.0f));
@@ -47,11 +58,45 @@ LowLatencyAudioProcessorEditor::LowLatencyAudioProcessorEditor (LowLatencyAudioP
     statusValueLabel.setColour(juce::Label::textColourId, juce::Colours::red);
     addAndMakeVisible(statusValueLabel);
     
+    // Configurar label de ocultações de underrun
+    concealmentLabel.setText("Ocultacoes:", juce::dontSendNotification);
+    concealmentLabel.setFont(juce::Font(14.0f));
+    addAndMakeVisible(concealmentLabel);
+    
+    // Configurar label de valor das ocultações
+    concealmentValueLabel.setText("0", juce::dontSendNotification);
+    concealmentValueLabel.setFont(juce::Font(14.0f));
+    concealmentValueLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(concealmentValueLabel);
+    
+    // Configurar label de continuidade do stream
+    continuityLabel.setText("Perdas/repet./overruns:", juce::dontSendNotification);
+    continuityLabel.setFont(juce::Font(14.0f));
+    addAndMakeVisible(continuityLabel);
+    
+    // Configurar label de valor da continuidade
+    continuityValueLabel.setText("0 / 0 / 0", juce::dontSendNotification);
+    continuityValueLabel.setFont(juce::Font(14.0f));
+    continuityValueLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(continuityValueLabel);
+    
+    // Configurar seleção de stream
+    streamLabel.setText("Stream:", juce::dontSendNotification);
+    streamLabel.setFont(juce::Font(14.0f));
+    addAndMakeVisible(streamLabel);
+    
+    refreshStreamList();
+    streamSelector.onChange = [this]() {
+        if (streamSelector.getSelectedId() > 0)
+            audioProcessor.setSelectedStream(streamSelector.getSelectedId());
+    };
+    addAndMakeVisible(streamSelector);
+    
     // Iniciar timer para atualização da interface
     startTimer(50); // Atualizar a cada 50 ms
     
     // Tamanho da janela do plugin
-    setSize (400, 200);
+    setSize (400, 400);
 }
 
 LowLatencyAudioProcessorEditor::~LowLatencyAudioProcessorEditor()
@@ -80,6 +125,11 @@ void LowLatencyAudioProcessorEditor::resized()
     auto buttonArea = area.removeFromTop(60);
     playButton.setBounds(buttonArea.reduced(80, 10));
 
+    // Layout da seleção de stream
+    auto streamArea = area.removeFromTop(40);
+    streamLabel.setBounds(streamArea.removeFromLeft(200).reduced(20, 5));
+    streamSelector.setBounds(streamArea.reduced(20, 5));
+    
     // Layout dos labels de status
     auto statusArea = area.removeFromTop(40);
     statusLabel.setBounds(statusArea.removeFromLeft(200).reduced(20, 5));
@@ -90,41 +140,63 @@ void LowLatencyAudioProcessorEditor::resized()
     latencyLabel.setBounds(latencyArea.removeFromLeft(200).reduced(20, 5));
     latencyValueLabel.setBounds(latencyArea.reduced(20, 5));
     
+    // Layout dos labels da idade das amostras
+    auto sampleAgeArea = area.removeFromTop(40);
+    sampleAgeLabel.setBounds(sampleAgeArea.removeFromLeft(200).reduced(20, 5));
+    sampleAgeValueLabel.setBounds(sampleAgeArea.reduced(20, 5));
+    
     // Layout dos labels de frequência
     auto freqArea = area.removeFromTop(40);
     frequencyLabel.setBounds(freqArea.removeFromLeft(200).reduced(20, 5));
     frequencyValueLabel.setBounds(freqArea.reduced(20, 5));
+    
+    // Layout dos labels de ocultação
+    auto concealmentArea = area.removeFromTop(40);
+    concealmentLabel.setBounds(concealmentArea.removeFromLeft(200).reduced(20, 5));
+    concealmentValueLabel.setBounds(concealmentArea.reduced(20, 5));
+    
+    // Layout dos labels de continuidade
+    auto continuityArea = area.removeFromTop(40);
+    continuityLabel.setBounds(continuityArea.removeFromLeft(200).reduced(20, 5));
+    continuityValueLabel.setBounds(continuityArea.reduced(20, 5));
 }
 
 void LowLatencyAudioProcessorEditor::timerCallback()
 {
-    // Atualizar a exibição de latência com valor filtrado para evitar oscilações extremas
+    // Atualizar a exibição de latência: o mesmo valor reportado ao host para a compensação de atraso
     float latency = audioProcessor.getCurrentLatency();
     
-    // Filtrar valores absurdos (acima de 1000ms provavelmente são erros)
-    if (latency > 0.0f && latency < 1000.0f) {
-        // Aplicar filtro de média móvel para suavizar a exibição
-        static float latencyHistory[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
-        static int historyIndex = 0;
-        
-        latencyHistory[historyIndex] = latency;
-        historyIndex = (historyIndex + 1) % 5;
-        
-        float averageLatency = 0.0f;
-        for (int i = 0; i < 5; ++i) {
-            averageLatency += latencyHistory[i];
-        }
-        averageLatency /= 5.0f;
-        
+    if (latency > 0.0f) {
         // Mostrar com apenas 1 casa decimal para melhor legibilidade
-        latencyValueLabel.setText(juce::String(averageLatency, 1) + " ms", juce::dontSendNotification);
+        latencyValueLabel.setText(juce::String(latency, 1) + " ms (" + juce::String(audioProcessor.getLatencySamples())
+                                  + " amostras)", juce::dontSendNotification);
     } else {
         latencyValueLabel.setText("--.- ms", juce::dontSendNotification);
     }
 
+    // Atualizar a idade medida das amostras (janela de 1 s)
+    const auto sampleAge = audioProcessor.getSampleAgeStatistics();
+    
+    if (sampleAge.numSamples > 0) {
+        sampleAgeValueLabel.setText(juce::String(sampleAge.minMs, 1) + " / " + juce::String(sampleAge.meanMs, 1) + " / "
+                                    + juce::String(sampleAge.p99Ms, 1) + " / " + juce::String(sampleAge.maxMs, 1) + " ms",
+                                    juce::dontSendNotification);
+    } else {
+        sampleAgeValueLabel.setText("--", juce::dontSendNotification);
+    }
+
+    // Atualizar a lista de streams cerca de uma vez por segundo
+    if (--streamListRefreshCountdown <= 0) {
+        refreshStreamList();
+        streamListRefreshCountdown = 20;
+    }
+    
     // Atualizar o status do gerador
     bool generatorActive = audioProcessor.isGeneratorActive();
-    if (generatorActive) {
+    if (audioProcessor.isStreamBusy()) {
+        statusValueLabel.setText("Stream em uso", juce::dontSendNotification);
+        statusValueLabel.setColour(juce::Label::textColourId, juce::Colours::orange);
+    } else if (generatorActive) {
         statusValueLabel.setText("Conectado", juce::dontSendNotification);
         statusValueLabel.setColour(juce::Label::textColourId, juce::Colours::green);
     } else {
@@ -135,7 +207,42 @@ void LowLatencyAudioProcessorEditor::timerCallback()
     // Atualizar a exibição de frequência
     float freq = audioProcessor.getCurrentFrequency();
     frequencyValueLabel.setText(juce::String(freq, 1) + " Hz", juce::dontSendNotification);
+    
+    // Atualizar o contador de ocultações (eventos e duração total ocultada)
+    const double concealedMs = audioProcessor.getConcealedFrames() * 1000.0 / juce::jmax(1.0, audioProcessor.getSampleRate());
+    concealmentValueLabel.setText(juce::String(audioProcessor.getConcealmentCount()) + " (" + juce::String(concealedMs, 0) + " ms)",
+                                  juce::dontSendNotification);
+    
+    // Atualizar os contadores de continuidade do stream: quadros perdidos e repetidos na
+    // linha do tempo da fonte e overruns do produtor (acumulados na memória compartilhada)
+    const auto counters = audioProcessor.getStreamCounters();
+    continuityValueLabel.setText(juce::String(static_cast<juce::int64>(counters.lostFrames)) + " / "
+                                 + juce::String(static_cast<juce::int64>(counters.repeatedFrames)) + " / "
+                                 + juce::String(static_cast<juce::int64>(counters.overruns)),
+                                 juce::dontSendNotification);
+    
     // Atualizar texto do botão
     playButton.setButtonText(audioProcessor.isPlaying() ? "Stop" : "Play");
 }
 
+void LowLatencyAudioProcessorEditor::refreshStreamList()
+{
+    // Não reconstruir a lista enquanto o usuário está escolhendo um item
+    if (streamSelector.isPopupActive())
+        return;
+    
+    streamSelector.clear(juce::dontSendNotification);
+    
+    for (int streamNumber = 1; streamNumber <= audioProcessor.getNumSelectableStreams(); ++streamNumber)
+    {
+        const auto info = audioProcessor.getStreamInfo(streamNumber);
+        juce::String text(streamNumber);
+        
+        if (info.active)
+            text += " - " + juce::String(info.name) + " (" + juce::String(info.numChannels) + " ch)";
+        
+        streamSelector.addItem(text, streamNumber);
+    }
+    
+    streamSelector.setSelectedId(audioProcessor.getSelectedStream(), juce::dontSendNotification);
+}
@@ -25,10 +25,21 @@ private:
     juce::TextButton playButton;
     juce::Label latencyLabel;
     juce::Label latencyValueLabel;
+    juce::Label sampleAgeLabel;
+    juce::Label sampleAgeValueLabel;
     juce::Label frequencyLabel;      
     juce::Label frequencyValueLabel; 
     juce::Label statusLabel;
     juce::Label statusValueLabel;
+    juce::Label concealmentLabel;
+    juce::Label concealmentValueLabel;
+    juce::Label continuityLabel;
+    juce::Label continuityValueLabel;
+    juce::Label streamLabel;
+    juce::ComboBox streamSelector;
+    int streamListRefreshCountdown = 0;
+    
+    void refreshStreamList();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LowLatencyAudioProcessorEditor)
 };
\ No newline at end of file
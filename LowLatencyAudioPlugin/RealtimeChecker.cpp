@@ -0,0 +1,442 @@
+#include "RealtimeChecker.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+ #define BRIDGE_RT_HAS_BACKTRACE 1
+#else
+ #define BRIDGE_RT_HAS_BACKTRACE 0
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+ #define BRIDGE_RT_UNDER_ASAN 1
+#elif defined(__has_feature)
+ #if __has_feature(address_sanitizer)
+  #define BRIDGE_RT_UNDER_ASAN 1
+ #endif
+#endif
+
+#ifndef BRIDGE_RT_UNDER_ASAN
+ #define BRIDGE_RT_UNDER_ASAN 0
+#endif
+
+#if BRIDGE_RT_CHECKS && JUCE_LINUX && defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define BRIDGE_RT_FORWARD_TO_NEXT 1
+ // Com ASan, o sanitizador é o malloc do processo e chama malloc antes de mapear a memória
+ // de sombra, que as substituições (instrumentadas) já acessariam: só new/delete são verificados
+ #define BRIDGE_RT_INTERPOSE_LIBC (! BRIDGE_RT_UNDER_ASAN)
+#else
+ #define BRIDGE_RT_FORWARD_TO_NEXT 0
+ #define BRIDGE_RT_INTERPOSE_LIBC 0
+#endif
+
+#if defined(__GNUC__)
+ // Sem passar pelo carregador dinâmico no primeiro acesso da thread (que pode alocar)
+ #define BRIDGE_RT_THREAD_LOCAL_MODEL __attribute__((tls_model("initial-exec")))
+#else
+ #define BRIDGE_RT_THREAD_LOCAL_MODEL
+#endif
+
+namespace
+{
+    // Inicialização constante: as substituições podem ser chamadas antes dos construtores estáticos
+    struct ViolationRecord {
+        std::atomic<bool> ready { false };
+        RealtimeChecker::Violation type = RealtimeChecker::Violation::Allocation;
+        int numFrames = 0;
+        void* frames[RealtimeChecker::maxStackFrames] = {};
+    };
+    
+    ViolationRecord violations[RealtimeChecker::maxViolations];
+    std::atomic<int> violationCount { 0 };
+    std::atomic<bool> abortOnViolation { false };
+    int reportedViolations = 0;         // thread de mensagens
+    bool overflowReported = false;
+    
+    // Profundidade de escopos de tempo real da thread; insideCheck evita que a captura
+    // da pilha (que pode alocar na primeira vez) se verifique de novo
+    thread_local int realtimeDepth BRIDGE_RT_THREAD_LOCAL_MODEL = 0;
+    thread_local bool insideCheck BRIDGE_RT_THREAD_LOCAL_MODEL = false;
+    
+    const char* getViolationName(RealtimeChecker::Violation violation)
+    {
+        switch (violation)
+        {
+            case RealtimeChecker::Violation::Allocation:    return "alocacao de memoria";
+            case RealtimeChecker::Violation::Deallocation:  return "liberacao de memoria";
+            case RealtimeChecker::Violation::MutexLock:     return "travamento de mutex";
+        }
+        
+        return "?";
+    }
+}
+
+void RealtimeChecker::initialise()
+{
+   #if BRIDGE_RT_HAS_BACKTRACE
+    // A primeira captura de pilha carrega o unwinder: fazê-la aqui, fora da thread de áudio
+    void* frames[2];
+    backtrace(frames, 2);
+   #endif
+   
+    const char* abortSetting = std::getenv("BRIDGE_RT_ABORT");
+    abortOnViolation.store(abortSetting != nullptr && std::atoi(abortSetting) != 0, std::memory_order_relaxed);
+}
+
+void RealtimeChecker::enterRealtimeContext() noexcept
+{
+    ++realtimeDepth;
+}
+
+void RealtimeChecker::exitRealtimeContext() noexcept
+{
+    --realtimeDepth;
+}
+
+void RealtimeChecker::check(Violation violation) noexcept
+{
+    if (realtimeDepth == 0 || insideCheck)
+        return;
+    
+    insideCheck = true;
+    
+    const int index = violationCount.fetch_add(1, std::memory_order_relaxed);
+    
+    if (index < maxViolations)
+    {
+        auto& record = violations[index];
+        record.type = violation;
+       
+       #if BRIDGE_RT_HAS_BACKTRACE
+        record.numFrames = backtrace(record.frames, maxStackFrames);
+       #endif
+       
+        record.ready.store(true, std::memory_order_release);
+        
+        // Modo CI: parar no ponto exato da violação, com a pilha em stderr
+        if (abortOnViolation.load(std::memory_order_relaxed))
+        {
+            std::fprintf(stderr, "Violacao de tempo real na thread de audio: %s\n", getViolationName(violation));
+           
+           #if BRIDGE_RT_HAS_BACKTRACE
+            backtrace_symbols_fd(record.frames, record.numFrames, fileno(stderr));
+           #endif
+           
+            std::abort();
+        }
+    }
+    
+    insideCheck = false;
+}
+
+int RealtimeChecker::getViolationCount()
+{
+    return violationCount.load(std::memory_order_relaxed);
+}
+
+int RealtimeChecker::reportViolations()
+{
+    const int total = violationCount.load(std::memory_order_acquire);
+    const int recorded = juce::jmin(total, static_cast<int>(maxViolations));
+    int written = 0;
+    
+    // Uma violação contada pode ainda estar capturando a pilha: parar nela e continuar no próximo relatório
+    while (reportedViolations < recorded && violations[reportedViolations].ready.load(std::memory_order_acquire))
+    {
+        const auto& record = violations[reportedViolations++];
+        juce::String message = juce::String("Violacao de tempo real na thread de audio: ") + getViolationName(record.type);
+       
+       #if BRIDGE_RT_HAS_BACKTRACE
+        // O primeiro quadro é o próprio check()
+        if (char** symbols = backtrace_symbols(record.frames, record.numFrames))
+        {
+            for (int frame = 1; frame < record.numFrames; ++frame)
+            {
+                message += "\n    ";
+                message += symbols[frame];
+            }
+            
+            std::free(symbols);
+        }
+       #endif
+       
+        juce::Logger::writeToLog(message);
+        ++written;
+    }
+    
+    if (total > maxViolations && reportedViolations == maxViolations && !overflowReported)
+    {
+        juce::Logger::writeToLog("Violacoes de tempo real alem das " + juce::String(static_cast<int>(maxViolations))
+                                 + " primeiras nao tem pilha registrada; total em getViolationCount()");
+        overflowReported = true;
+    }
+    
+    return written;
+}
+
+//==============================================================================
+// Substituições (somente com BRIDGE_RT_CHECKS)
+#if BRIDGE_RT_CHECKS
+
+#if BRIDGE_RT_FORWARD_TO_NEXT
+namespace
+{
+    // As substituições só observam: cada uma segue para a próxima definição na ordem de
+    // busca (o glibc, ou ASan/jemalloc/tcmalloc quando estão na frente), nunca direto para
+    // o glibc, para que memória alocada por um alocador não seja liberada por outro
+    using MallocFunction = void* (*)(size_t);
+    using CallocFunction = void* (*)(size_t, size_t);
+    using ReallocFunction = void* (*)(void*, size_t);
+    using MemalignFunction = int (*)(void**, size_t, size_t);
+    using AlignedAllocFunction = void* (*)(size_t, size_t);
+    using FreeFunction = void (*)(void*);
+    using LockFunction = int (*)(pthread_mutex_t*);
+    
+    // Inicialização constante, sem a guarda de um static local (que travaria um mutex)
+    std::atomic<MallocFunction> nextMalloc { nullptr };
+    std::atomic<CallocFunction> nextCalloc { nullptr };
+    std::atomic<ReallocFunction> nextRealloc { nullptr };
+    std::atomic<MemalignFunction> nextPosixMemalign { nullptr };
+    std::atomic<AlignedAllocFunction> nextAlignedAlloc { nullptr };
+    std::atomic<FreeFunction> nextFree { nullptr };
+    std::atomic<LockFunction> nextLock { nullptr };
+    std::atomic<MallocFunction> nextNew { nullptr };
+    std::atomic<MallocFunction> nextNewArray { nullptr };
+    std::atomic<FreeFunction> nextDelete { nullptr };
+    std::atomic<FreeFunction> nextDeleteArray { nullptr };
+    
+    // dlsym pode alocar (calloc do resultado de dlerror): enquanto a thread resolve, malloc e
+    // calloc saem de uma arena estática, zerada e nunca reaproveitada
+    constexpr size_t bootstrapArenaSize = 16384;
+    alignas(std::max_align_t) char bootstrapArena[bootstrapArenaSize];
+    std::atomic<size_t> bootstrapUsed { 0 };
+    thread_local bool resolvingNext BRIDGE_RT_THREAD_LOCAL_MODEL = false;
+    
+    // new/delete já verificados seguindo para a libstdc++, que chama malloc/free: não contar de novo
+    thread_local bool forwardingOperator BRIDGE_RT_THREAD_LOCAL_MODEL = false;
+    
+   #if BRIDGE_RT_INTERPOSE_LIBC
+    void checkUnlessForwarding(RealtimeChecker::Violation violation)
+    {
+        if (!forwardingOperator)
+            RealtimeChecker::check(violation);
+    }
+   #endif
+    
+    void* bootstrapAllocate(size_t size)
+    {
+        const size_t alignment = alignof(std::max_align_t);
+        const size_t rounded = (size + alignment - 1) & ~(alignment - 1);
+        const size_t offset = bootstrapUsed.fetch_add(rounded, std::memory_order_relaxed);
+        
+        return offset + rounded <= bootstrapArenaSize ? bootstrapArena + offset : nullptr;
+    }
+    
+    bool isBootstrapPointer(const void* pointer)
+    {
+        const char* bytes = static_cast<const char*>(pointer);
+        return bytes >= bootstrapArena && bytes < bootstrapArena + bootstrapArenaSize;
+    }
+    
+    template <typename Function>
+    Function resolveNext(std::atomic<Function>& cache, const char* name)
+    {
+        auto function = cache.load(std::memory_order_acquire);
+        
+        if (function == nullptr)
+        {
+            resolvingNext = true;
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+            resolvingNext = false;
+            cache.store(function, std::memory_order_release);
+        }
+        
+        return function;
+    }
+    
+    void* allocateNext(size_t size)
+    {
+        if (resolvingNext)
+            return bootstrapAllocate(size);
+        
+        return resolveNext(nextMalloc, "malloc")(size);
+    }
+    
+    void freeNext(void* pointer)
+    {
+        if (pointer == nullptr || isBootstrapPointer(pointer))
+            return;
+        
+        resolveNext(nextFree, "free")(pointer);
+    }
+}
+
+#if BRIDGE_RT_INTERPOSE_LIBC
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        checkUnlessForwarding(RealtimeChecker::Violation::Allocation);
+        return allocateNext(size);
+    }
+    
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        checkUnlessForwarding(RealtimeChecker::Violation::Allocation);
+        
+        if (resolvingNext)
+            return size == 0 || count <= bootstrapArenaSize / size ? bootstrapAllocate(count * size) : nullptr;
+        
+        return resolveNext(nextCalloc, "calloc")(count, size);
+    }
+    
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        checkUnlessForwarding(RealtimeChecker::Violation::Allocation);
+        
+        // Um bloco da arena não é conhecido do alocador seguinte: copiar para um bloco dele
+        // (o tamanho original não é guardado; copiar até o fim da arena no máximo)
+        if (pointer != nullptr && isBootstrapPointer(pointer))
+        {
+            void* moved = allocateNext(size);
+            const size_t available = static_cast<size_t>(bootstrapArena + bootstrapArenaSize - static_cast<char*>(pointer));
+            
+            if (moved != nullptr)
+                std::memcpy(moved, pointer, juce::jmin(size, available));
+            
+            return moved;
+        }
+        
+        return resolveNext(nextRealloc, "realloc")(pointer, size);
+    }
+    
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        checkUnlessForwarding(RealtimeChecker::Violation::Allocation);
+        return resolveNext(nextPosixMemalign, "posix_memalign")(result, alignment, size);
+    }
+    
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        checkUnlessForwarding(RealtimeChecker::Violation::Allocation);
+        return resolveNext(nextAlignedAlloc, "aligned_alloc")(alignment, size);
+    }
+    
+    void free(void* pointer) noexcept
+    {
+        if (pointer != nullptr)
+            checkUnlessForwarding(RealtimeChecker::Violation::Deallocation);
+        
+        freeNext(pointer);
+    }
+    
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        RealtimeChecker::check(RealtimeChecker::Violation::MutexLock);
+        return resolveNext(nextLock, "pthread_mutex_lock")(mutex);
+    }
+}
+#endif
+
+// new/delete também seguem para os operadores seguintes (os da libstdc++, ou os de um
+// alocador à frente dela), não para malloc/free: ASan distingue os dois tipos de alocação
+static_assert (sizeof(std::size_t) == sizeof(unsigned long), "Nomes decorados abaixo supõem size_t = unsigned long");
+
+static void* allocateUnchecked(std::size_t size, bool array)
+{
+    auto allocate = array ? resolveNext(nextNewArray, "_Znam") : resolveNext(nextNew, "_Znwm");
+    
+    if (allocate == nullptr)
+        return allocateNext(size);
+    
+    // O operador seguinte lança bad_alloc; as variantes nothrow abaixo o capturam
+    forwardingOperator = true;
+    void* pointer = nullptr;
+    
+    try
+    {
+        pointer = allocate(size);
+    }
+    catch (...)
+    {
+        forwardingOperator = false;
+        throw;
+    }
+    
+    forwardingOperator = false;
+    return pointer;
+}
+
+static void freeUnchecked(void* pointer, bool array)
+{
+    if (isBootstrapPointer(pointer))
+        return;
+    
+    auto release = array ? resolveNext(nextDeleteArray, "_ZdaPv") : resolveNext(nextDelete, "_ZdlPv");
+    
+    forwardingOperator = true;
+    
+    if (release == nullptr)
+        freeNext(pointer);
+    else
+        release(pointer);
+    
+    forwardingOperator = false;
+}
+#else
+static void* allocateUnchecked(std::size_t size, bool)    { return std::malloc(size); }
+static void freeUnchecked(void* pointer, bool)            { std::free(pointer); }
+#endif
+
+// Operadores globais (as variantes alinhadas ficam com a implementação padrão, que
+// no Linux passa por aligned_alloc/free acima)
+static void* allocateChecked(std::size_t size, bool array)
+{
+    RealtimeChecker::check(RealtimeChecker::Violation::Allocation);
+    
+    if (void* pointer = allocateUnchecked(size == 0 ? 1 : size, array))
+        return pointer;
+    
+    throw std::bad_alloc();
+}
+
+static void* allocateCheckedNoThrow(std::size_t size, bool array) noexcept
+{
+    try
+    {
+        return allocateChecked(size, array);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+static void freeChecked(void* pointer, bool array) noexcept
+{
+    if (pointer == nullptr)
+        return;
+    
+    RealtimeChecker::check(RealtimeChecker::Violation::Deallocation);
+    freeUnchecked(pointer, array);
+}
+
+void* operator new(std::size_t size)                                   { return allocateChecked(size, false); }
+void* operator new[](std::size_t size)                                 { return allocateChecked(size, true); }
+void operator delete(void* pointer) noexcept                           { freeChecked(pointer, false); }
+void operator delete[](void* pointer) noexcept                         { freeChecked(pointer, true); }
+void operator delete(void* pointer, std::size_t) noexcept              { freeChecked(pointer, false); }
+void operator delete[](void* pointer, std::size_t) noexcept            { freeChecked(pointer, true); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept    { freeChecked(pointer, false); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept  { freeChecked(pointer, true); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept   { return allocateCheckedNoThrow(size, false); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocateCheckedNoThrow(size, true); }
+
+#endif
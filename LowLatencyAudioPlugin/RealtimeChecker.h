@@ -0,0 +1,72 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <atomic>
+#include <cstdint>
+
+// Verificação de tempo real da thread de áudio (modo de depuração/CI opcional)
+//
+// Compilado com BRIDGE_RT_CHECKS=1 (opção BRIDGE_RT_CHECKS do CMake), o plugin
+// substitui os operadores new/delete e, no Linux (glibc), malloc/calloc/realloc/free
+// e pthread_mutex_lock por versões que, quando a thread atual está dentro de um
+// escopo de tempo real (BRIDGE_RT_SCOPE, aberto em processBlock), registram a
+// violação com a pilha de chamadas e seguem para a próxima definição do símbolo
+// (dlsym(RTLD_NEXT, ...)): o verificador só observa as chamadas, e o alocador do
+// processo (glibc, jemalloc, tcmalloc, ASan) continua o mesmo. O registro não
+// aloca nem trava: as violações vão para uma tabela fixa, e reportViolations() (thread
+// de mensagens) as escreve no log com os símbolos da pilha. Com BRIDGE_RT_ABORT=1 no
+// ambiente, a primeira violação é escrita em stderr e aborta o processo, para que o
+// CI falhe no ponto exato. Compilado com AddressSanitizer, só new/delete são
+// verificados: o sanitizador chama malloc antes de estar pronto para o código instrumentado.
+//
+// No Linux, o plugin é ligado com -Bsymbolic-functions neste modo: as chamadas do
+// próprio plugin (e do JUCE compilado nele) chegam às substituições, e o host que
+// carrega o VST3 continua com as funções originais. No Standalone, elas valem para
+// o processo inteiro, mas só as threads em escopo de tempo real são verificadas.
+//
+// Sem BRIDGE_RT_CHECKS, as macros abaixo não geram código.
+class RealtimeChecker
+{
+public:
+    enum class Violation : uint8_t {
+        Allocation,
+        Deallocation,
+        MutexLock
+    };
+    
+    // Prepara a captura de pilha e lê BRIDGE_RT_ABORT (chamar fora da thread de áudio)
+    static void initialise();
+    
+    // Escreve no log as violações ainda não relatadas; retorna quantas foram escritas
+    static int reportViolations();
+    
+    // Total de violações desde o início (inclusive as que não couberam na tabela)
+    static int getViolationCount();
+    
+    // Chamado pelas substituições: registra a violação se a thread está em um escopo de tempo real
+    static void check(Violation violation) noexcept;
+    
+    static void enterRealtimeContext() noexcept;
+    static void exitRealtimeContext() noexcept;
+    
+    // Trecho em que a thread atual não pode alocar nem travar
+    class ScopedRealtimeContext
+    {
+    public:
+        ScopedRealtimeContext() noexcept { enterRealtimeContext(); }
+        ~ScopedRealtimeContext() { exitRealtimeContext(); }
+    };
+    
+    static constexpr int maxViolations = 64;
+    static constexpr int maxStackFrames = 32;
+};
+
+#if BRIDGE_RT_CHECKS
+ #define BRIDGE_RT_INITIALISE() RealtimeChecker::initialise()
+ #define BRIDGE_RT_SCOPE() RealtimeChecker::ScopedRealtimeContext bridgeRealtimeScope
+ #define BRIDGE_RT_REPORT() RealtimeChecker::reportViolations()
+#else
+ #define BRIDGE_RT_INITIALISE()
+ #define BRIDGE_RT_SCOPE()
+ #define BRIDGE_RT_REPORT()
+#endif
@@ -1,41 +1,281 @@
 #include "SharedMemoryManager.h"
+#include "TraceRecorder.h"
+#include <new>
+#include <thread>
 
 #if JUCE_WINDOWS
     #include <windows.h>
 #elif JUCE_LINUX
+    #include <cerrno>
+    #include <climits>
+    #include <cstring>
+    #include <csignal>
+    #include <ctime>
     #include <fcntl.h>
     #include <unistd.h>
+    #include <linux/futex.h>
+    #include <sys/file.h>
     #include <sys/mman.h>
     #include <sys/stat.h>
+    #include <sys/statfs.h>
+    #include <sys/syscall.h>
+    
+    // Constantes de mbind/get_mempolicy (numaif.h vem da libnuma, que não usamos)
+    #define BRIDGE_MPOL_PREFERRED   1
+    #define BRIDGE_MPOL_MF_MOVE     (1 << 1)
+    #define BRIDGE_MPOL_F_NODE      (1 << 0)
+    #define BRIDGE_MPOL_F_ADDR      (1 << 1)
+    #define BRIDGE_HUGETLBFS_MAGIC  0x958458f6
 #elif JUCE_MAC
+    #include <cerrno>
+    #include <csignal>
+    #include <ctime>
     #include <fcntl.h>
     #include <unistd.h>
+    #include <sys/file.h>
     #include <sys/mman.h>
     #include <sys/stat.h>
 #endif
 
+#if JUCE_INTEL
+    #include <immintrin.h>
+#endif
+
+// Pausa curta dentro de laços de espera ativa
+static inline void cpuRelax()
+{
+#if JUCE_INTEL
+    _mm_pause();
+#elif JUCE_ARM && (defined (__GNUC__) || defined (__clang__))
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+// Dorme enquanto a palavra valer expected, por no máximo timeoutUs microssegundos.
+// No Linux é um futex sem FUTEX_PRIVATE_FLAG, para funcionar entre processos
+static void waitOnSharedWord(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeoutUs)
+{
+#if JUCE_LINUX
+    struct timespec timeout;
+    timeout.tv_sec = static_cast<time_t>(timeoutUs / 1000000);
+    timeout.tv_nsec = static_cast<long>((timeoutUs % 1000000) * 1000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+    // Sem espera entre processos disponível: dormir um intervalo curto e deixar o chamador reavaliar
+    if (word.load(std::memory_order_acquire) == expected)
+        std::this_thread::sleep_for(std::chrono::microseconds(juce::jmin<int64_t>(timeoutUs, 500)));
+#endif
+}
+
+static void wakeSharedWord(std::atomic<uint32_t>& word)
+{
+#if JUCE_LINUX
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    juce::ignoreUnused(word);
+#endif
+}
+
+// Espera híbrida usada pelo produtor: gira por spinMicroseconds e depois dorme na
+// palavra sequence, marcando waiting para que o outro lado saiba que precisa tocar.
+// Retorna true assim que condition() for verdadeira, false no timeout ou se a
+// campainha tocar sem que a condição tenha sido atingida (ex.: interruptWait)
+template <typename Condition>
+static bool spinThenWait(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& waiting,
+                         int spinMicroseconds, int timeoutMs, Condition&& condition)
+{
+    // Fase 1: espera ativa curta, que cobre o caso em que o outro lado está prestes a agir
+    const auto start = std::chrono::steady_clock::now();
+    const auto spinDeadline = start + std::chrono::microseconds(spinMicroseconds);
+    
+    do
+    {
+        if (condition())
+            return true;
+        
+        cpuRelax();
+    }
+    while (std::chrono::steady_clock::now() < spinDeadline);
+    
+    // Fase 2: dormir na campainha até ela tocar ou o tempo acabar
+    const auto deadline = start + std::chrono::milliseconds(timeoutMs);
+    
+    for (;;)
+    {
+        const uint32_t sequenceBefore = sequence.load(std::memory_order_acquire);
+        waiting.store(1, std::memory_order_seq_cst);
+        
+        // Par com o fence de quem toca: ou vemos o novo estado antes de dormir,
+        // ou o outro lado vê waiting e nos acorda
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        if (condition())
+        {
+            waiting.store(0, std::memory_order_relaxed);
+            return true;
+        }
+        
+        const auto remainingUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                     deadline - std::chrono::steady_clock::now()).count();
+        
+        if (remainingUs <= 0)
+        {
+            waiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        
+        waitOnSharedWord(sequence, sequenceBefore, remainingUs);
+        
+        // Campainha tocada: devolver o controle ao chamador
+        if (sequence.load(std::memory_order_acquire) != sequenceBefore)
+            return condition();
+    }
+}
+
+// Lado de quem toca: só faz a chamada de sistema se houver alguém esperando
+static void ringSharedDoorbell(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& waiting)
+{
+    if (waiting.exchange(0, std::memory_order_acq_rel) != 0)
+    {
+        sequence.fetch_add(1, std::memory_order_release);
+        wakeSharedWord(sequence);
+    }
+}
+
+// Palavra do seqlock: contador nos 32 bits baixos, PID de quem escreve nos 32 altos
+static inline uint64_t makeSeqLockWord(uint32_t count, int pid)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32) | count;
+}
+
+// Escrita num bloco protegido por seqlock. Escritores do mesmo processo ou de processos
+// diferentes se excluem tornando o contador ímpar com CAS, que grava o PID do escritor na
+// mesma palavra. Um escritor vivo nunca é ultrapassado, por mais que fique preemptado; só
+// se o processo dono da escrita não existe mais o próximo a assume, mantendo o contador
+// ímpar. A escrita termina com CAS, para que um escritor que perdeu o bloco não desfaça o
+// contador de quem o assumiu
+template <typename Fields, typename Writer>
+static void writeSeqLocked(Fields& fields, Writer&& write)
+{
+    constexpr int spinsBetweenOwnerChecks = 4096;
+    const int myPid = SharedMemoryManager::getProcessId();
+    uint64_t word = fields.sequence.load(std::memory_order_relaxed);
+    uint64_t claimed = 0;
+    int spins = 0;
+    
+    for (;;)
+    {
+        const auto count = static_cast<uint32_t>(word);
+        
+        if ((count & 1) == 0)
+        {
+            // Contador par: tentar tomar a escrita (em caso de falha, word recebe o valor atual)
+            claimed = makeSeqLockWord(count + 1, myPid);
+            
+            if (fields.sequence.compare_exchange_weak(word, claimed, std::memory_order_acquire,
+                                                      std::memory_order_relaxed))
+                break;
+            
+            continue;
+        }
+        
+        // Escrita em andamento: de tempos em tempos, ver se o processo que a faz ainda existe
+        if (++spins % spinsBetweenOwnerChecks == 0)
+        {
+            const int writer = static_cast<int>(static_cast<uint32_t>(word >> 32));
+            
+            if (writer != myPid && !SharedMemoryManager::isProcessAlive(writer))
+            {
+                claimed = makeSeqLockWord(count + 2, myPid);
+                
+                if (fields.sequence.compare_exchange_strong(word, claimed, std::memory_order_acquire,
+                                                            std::memory_order_relaxed))
+                    break;
+                
+                continue;
+            }
+        }
+        
+        cpuRelax();
+        word = fields.sequence.load(std::memory_order_relaxed);
+    }
+    
+    std::atomic_thread_fence(std::memory_order_release);
+    write(fields);
+    
+    // Falha só se outro escritor assumiu o bloco achando que este processo tinha morrido:
+    // a escrita dele prevalece
+    uint64_t expected = claimed;
+    fields.sequence.compare_exchange_strong(expected, makeSeqLockWord(static_cast<uint32_t>(claimed) + 1, 0),
+                                            std::memory_order_release, std::memory_order_relaxed);
+}
+
+// Leitura de um bloco protegido por seqlock: nunca bloqueia. Repete enquanto uma escrita
+// estiver em andamento, até um limite de tentativas (cada campo é atômico, então no pior
+// caso o instantâneo mistura valores de duas escritas, mas nenhum valor é inválido).
+// Retorna o contador de mudanças do instantâneo lido
+template <typename Fields, typename Reader>
+static uint32_t readSeqLocked(const Fields& fields, Reader&& read)
+{
+    constexpr int maxAttempts = 64;
+    uint32_t before = 0;
+    
+    for (int attempt = 0; attempt < maxAttempts; ++attempt)
+    {
+        before = static_cast<uint32_t>(fields.sequence.load(std::memory_order_acquire));
+        
+        if ((before & 1) == 0)
+        {
+            read(fields);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            
+            if (static_cast<uint32_t>(fields.sequence.load(std::memory_order_relaxed)) == before)
+                return before / 2;
+        }
+        
+        cpuRelax();
+    }
+    
+    read(fields);
+    return before / 2;
+}
+
 // Implementação da classe PlatformSharedMemory
-SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const std::string& name, size_t size)
-    : memoryName(name), memSize(size), data(nullptr), isCreated(false), isOwner(false)
+SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const Config& config, size_t size)
+    : memoryName(config.segmentName), memSize(size), data(nullptr), isCreated(false), isOwner(false)
 {
+    const std::string& name = config.segmentName;
+    const bool readOnly = config.readOnly;
+
 #if JUCE_WINDOWS
+    const DWORD access = readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS;
+    
     // Tentar abrir memória compartilhada existente
-    fileHandle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    fileHandle = OpenFileMappingA(access, FALSE, name.c_str());
     
-    if (fileHandle == nullptr)
+    if (fileHandle == nullptr && !readOnly)
     {
-        // Criar nova memória compartilhada
-        fileHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, 
-                                       static_cast<DWORD>(size), name.c_str());
-        isOwner = (fileHandle != nullptr);
+        // Criar nova memória compartilhada (o tamanho vai em duas palavras de 32 bits: segmentos
+        // de 4 GiB ou mais são possíveis com muitos slots, canais e capacidade máxima)
+        const uint64_t size64 = static_cast<uint64_t>(size);
+        fileHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                       static_cast<DWORD>(size64 & 0xffffffffULL), name.c_str());
+        isOwner = (fileHandle != nullptr && GetLastError() != ERROR_ALREADY_EXISTS);
     }
     
     if (fileHandle != nullptr)
     {
         // Mapear a memória compartilhada para o espaço de endereço do processo
-        data = MapViewOfFile(fileHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        // (ao abrir um segmento existente, mapear o objeto inteiro e descobrir o tamanho real)
+        data = MapViewOfFile(fileHandle, access, 0, 0, isOwner ? size : 0);
         isCreated = (data != nullptr);
         
+        if (isCreated && !isOwner)
+        {
+            MEMORY_BASIC_INFORMATION info;
+            memSize = VirtualQuery(data, &info, sizeof(info)) != 0 ? static_cast<size_t>(info.RegionSize) : 0;
+        }
+        
         if (isOwner && isCreated)
         {
             // Se fomos nós que criamos, inicializar a memória
@@ -47,12 +287,31 @@ SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const std::strin
     std::string fullName = "/" + name; // Adicionar slash para caminho absoluto
     
     // Tentar abrir memória compartilhada existente
-    fileDescriptor = shm_open(fullName.c_str(), O_RDWR, 0666);
+    fileDescriptor = shm_open(fullName.c_str(), readOnly ? O_RDONLY : O_RDWR, 0666);
+   
+   #if JUCE_LINUX
+    // O segmento pode ter sido criado no hugetlbfs por outro processo (hugePages)
+    const std::string hugeTlbName = config.hugePageDirectory + fullName;
     
     if (fileDescriptor == -1)
     {
-        // Criar nova memória compartilhada
-        fileDescriptor = shm_open(fullName.c_str(), O_CREAT | O_RDWR, 0666);
+        fileDescriptor = open(hugeTlbName.c_str(), readOnly ? O_RDONLY : O_RDWR);
+        
+        if (fileDescriptor != -1)
+        {
+            hugeTlb = true;
+            hugeTlbPath = hugeTlbName;
+        }
+    }
+    
+    if (fileDescriptor == -1 && !readOnly && config.hugePages)
+        createHugeTlbSegment(hugeTlbName, size);
+   #endif
+   
+    if (fileDescriptor == -1 && !readOnly)
+    {
+        // Criar nova memória compartilhada (O_EXCL: se outro processo criou no meio-tempo, abrimos o dele)
+        fileDescriptor = shm_open(fullName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
         isOwner = (fileDescriptor != -1);
         
         if (isOwner)
@@ -61,16 +320,66 @@ SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const std::strin
             if (ftruncate(fileDescriptor, static_cast<off_t>(size)) == -1)
             {
                 close(fileDescriptor);
+                shm_unlink(fullName.c_str());
                 fileDescriptor = -1;
                 isOwner = false;
             }
         }
+        else if (errno == EEXIST)
+        {
+            fileDescriptor = shm_open(fullName.c_str(), O_RDWR, 0666);
+        }
+    }
+    
+    if (fileDescriptor != -1 && !readOnly)
+    {
+        // Trava compartilhada enquanto conectado. Quem remove o nome ao sair segura a
+        // exclusiva: se o nome sumiu antes de obtermos a nossa, abrimos o objeto antigo
+        struct stat info;
+        
+        if (flock(fileDescriptor, LOCK_SH) == 0 && fstat(fileDescriptor, &info) == 0 && info.st_nlink == 0)
+        {
+            close(fileDescriptor);
+            fileDescriptor = -1;
+            isOwner = false;
+            removedWhileOpening = true;
+        }
+    }
+    
+    if (fileDescriptor != -1 && !isOwner)
+    {
+        // Segmento já existe: o tamanho real vem do objeto, não do chamador.
+        // O criador pode ainda não ter chamado ftruncate, então esperar um pouco
+        struct stat info;
+        memSize = 0;
+        
+        for (int attempt = 0; attempt < 100 && memSize == 0; ++attempt)
+        {
+            if (fstat(fileDescriptor, &info) == 0)
+                memSize = static_cast<size_t>(info.st_size);
+            
+            if (memSize == 0)
+                usleep(5000);
+        }
+        
+        if (memSize == 0)
+        {
+            close(fileDescriptor);
+            fileDescriptor = -1;
+        }
+       
+       #if JUCE_LINUX
+        struct statfs fileSystemInfo;
+        
+        if (hugeTlb && fileDescriptor != -1 && fstatfs(fileDescriptor, &fileSystemInfo) == 0)
+            pageSize = static_cast<size_t>(fileSystemInfo.f_bsize);
+       #endif
     }
     
     if (fileDescriptor != -1)
     {
         // Mapear a memória compartilhada
-        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        data = mmap(nullptr, memSize, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
         
         if (data == MAP_FAILED)
         {
@@ -78,7 +387,13 @@ SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const std::strin
         }
         
         isCreated = (data != nullptr);
-        
+       
+       #if JUCE_LINUX
+        // Antes de o criador zerar o segmento: é nesse memset que as páginas são alocadas
+        if (isCreated)
+            applyPlacement(config);
+       #endif
+       
         if (isOwner && isCreated)
         {
             // Se fomos nós que criamos, inicializar a memória
@@ -88,6 +403,122 @@ SharedMemoryManager::PlatformSharedMemory::PlatformSharedMemory(const std::strin
 #endif
 }
 
+#if JUCE_LINUX
+void SharedMemoryManager::PlatformSharedMemory::createHugeTlbSegment(const std::string& path, size_t size)
+{
+    fileDescriptor = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    
+    if (fileDescriptor == -1)
+    {
+        if (errno == EEXIST)
+        {
+            // Outro processo criou no meio-tempo: abrir o dele
+            fileDescriptor = open(path.c_str(), O_RDWR);
+            hugeTlb = (fileDescriptor != -1);
+            hugeTlbPath = path;
+        }
+        else
+        {
+            juce::Logger::writeToLog("hugetlbfs indisponivel em " + juce::String(path) + " ("
+                                     + juce::String(strerror(errno)) + "); usando paginas comuns");
+        }
+        
+        return;
+    }
+    
+    // O diretório precisa ser um hugetlbfs montado; o tamanho tem de ser múltiplo da página enorme
+    struct statfs fileSystemInfo;
+    const bool isHugeTlbFs = fstatfs(fileDescriptor, &fileSystemInfo) == 0
+                             && static_cast<uint32_t>(fileSystemInfo.f_type) == static_cast<uint32_t>(BRIDGE_HUGETLBFS_MAGIC);
+    const size_t hugePageSize = isHugeTlbFs ? static_cast<size_t>(fileSystemInfo.f_bsize) : 0;
+    const size_t roundedSize = hugePageSize > 0 ? (size + hugePageSize - 1) / hugePageSize * hugePageSize : 0;
+    
+    // As páginas enormes são reservadas no mmap, não no ftruncate: com o pool vazio só o
+    // mmap falha, então testar aqui enquanto ainda dá para recuar para o shm comum
+    void* probe = MAP_FAILED;
+    
+    if (roundedSize > 0 && ftruncate(fileDescriptor, static_cast<off_t>(roundedSize)) == 0)
+        probe = mmap(nullptr, roundedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    
+    if (probe == MAP_FAILED)
+    {
+        juce::Logger::writeToLog(juce::String(isHugeTlbFs ? "Sem paginas enormes livres em " : "Nao e um hugetlbfs: ")
+                                 + juce::String(path) + "; usando paginas comuns");
+        close(fileDescriptor);
+        ::unlink(path.c_str());
+        fileDescriptor = -1;
+        return;
+    }
+    
+    munmap(probe, roundedSize);
+    
+    isOwner = true;
+    hugeTlb = true;
+    hugeTlbPath = path;
+    memSize = roundedSize;
+    pageSize = hugePageSize;
+}
+
+void SharedMemoryManager::PlatformSharedMemory::applyPlacement(const Config& config)
+{
+   #ifdef MADV_HUGEPAGE
+    // Sem hugetlbfs, pedir páginas enormes transparentes para o shmem
+    // (só têm efeito com /sys/kernel/mm/transparent_hugepage/shmem_enabled em "advise")
+    if (config.hugePages && !hugeTlb)
+        transparentHugePages = madvise(data, memSize, MADV_HUGEPAGE) == 0;
+   #endif
+   
+    if (config.numaNode < 0)
+        return;
+    
+    // Em shmem e hugetlbfs a política fica no objeto: vale para as páginas ainda não
+    // alocadas, inclusive as que o outro processo tocar primeiro
+    constexpr int maxNumaNodes = 1024;
+    constexpr int bitsPerWord = static_cast<int>(sizeof(unsigned long) * 8);
+    unsigned long nodeMask[maxNumaNodes / bitsPerWord] = {};
+    
+    if (config.numaNode >= maxNumaNodes)
+    {
+        juce::Logger::writeToLog("No NUMA invalido: " + juce::String(config.numaNode));
+        return;
+    }
+    
+    nodeMask[config.numaNode / bitsPerWord] |= 1UL << (config.numaNode % bitsPerWord);
+    
+    if (syscall(SYS_mbind, data, memSize, BRIDGE_MPOL_PREFERRED, nodeMask,
+                static_cast<unsigned long>(maxNumaNodes + 1), BRIDGE_MPOL_MF_MOVE) != 0)
+    {
+        juce::Logger::writeToLog("mbind para o no NUMA " + juce::String(config.numaNode)
+                                 + " falhou (" + juce::String(strerror(errno)) + ")");
+    }
+}
+#endif
+
+bool SharedMemoryManager::PlatformSharedMemory::lock()
+{
+#if JUCE_WINDOWS
+    // Limitado pelo working set mínimo do processo (SetProcessWorkingSetSize)
+    return data != nullptr && VirtualLock(data, memSize) != 0;
+#elif JUCE_MAC || JUCE_LINUX
+    return data != nullptr && mlock(data, memSize) == 0;
+#else
+    return false;
+#endif
+}
+
+int SharedMemoryManager::PlatformSharedMemory::getNumaNode() const
+{
+#if JUCE_LINUX
+    int node = -1;
+    
+    if (data != nullptr
+        && syscall(SYS_get_mempolicy, &node, nullptr, 0UL, data, BRIDGE_MPOL_F_NODE | BRIDGE_MPOL_F_ADDR) == 0)
+        return node;
+#endif
+
+    return -1;
+}
+
 SharedMemoryManager::PlatformSharedMemory::~PlatformSharedMemory()
 {
 #if JUCE_WINDOWS
@@ -109,17 +540,41 @@ SharedMemoryManager::PlatformSharedMemory::~PlatformSharedMemory()
     if (fileDescriptor != -1)
     {
         close(fileDescriptor);
-        
-        // Se somos o dono, remover o objeto de memória compartilhada
-        if (isOwner)
-        {
-            std::string fullName = "/" + memoryName;
-            shm_unlink(fullName.c_str());
-        }
     }
 #endif
 }
 
+void SharedMemoryManager::PlatformSharedMemory::unlink()
+{
+#if JUCE_MAC || JUCE_LINUX
+    // No Windows o objeto some sozinho quando o último handle é fechado
+    if (hugeTlb)
+    {
+        ::unlink(hugeTlbPath.c_str());
+        return;
+    }
+    
+    std::string fullName = "/" + memoryName;
+    shm_unlink(fullName.c_str());
+#endif
+}
+
+bool SharedMemoryManager::PlatformSharedMemory::tryLockExclusive()
+{
+#if JUCE_MAC || JUCE_LINUX
+    if (fileDescriptor == -1)
+        return false;
+    
+    if (flock(fileDescriptor, LOCK_EX | LOCK_NB) == 0)
+        return true;
+    
+    return errno != EWOULDBLOCK;
+#else
+    // No Windows o nome só existe enquanto houver um handle aberto
+    return false;
+#endif
+}
+
 // Implementação da classe SharedMemoryManager
 SharedMemoryManager::SharedMemoryManager()
     : sharedData(nullptr), initialized(false)
@@ -128,139 +583,1287 @@ SharedMemoryManager::SharedMemoryManager()
 
 SharedMemoryManager::~SharedMemoryManager()
 {
+    if (initialized && sharedData != nullptr && !readOnly)
+    {
+        if (isProducer)
+            unregisterStream();
+        else
+            detachStream();
+        
+        // Remover o nome do segmento só quando ninguém mais o usa. A decisão vem de PIDs e
+        // travas, que morrem com o processo: um gerador ou host que caiu não segura o segmento
+        if (sharedMemoryBlock->tryLockExclusive() && !hasLiveUsers())
+            sharedMemoryBlock->unlink();
+    }
+    
     sharedMemoryBlock.reset();
 }
 
-bool SharedMemoryManager::initialize()
+void SharedMemoryManager::prefault() const
 {
-    std::unique_lock<std::mutex> lock(accessMutex);
-    
-    // Criar/abrir memória compartilhada
-    sharedMemoryBlock = std::make_unique<PlatformSharedMemory>(sharedMemoryName, sharedMemorySize);
-    
-    if (!sharedMemoryBlock->isValid())
-    {
-        return false;
-    }
+    if (!initialized || sharedMemoryBlock == nullptr)
+        return;
     
-    // Obter ponteiro para os dados
-    sharedData = static_cast<AudioSharedData*>(sharedMemoryBlock->getData());
+    const auto* bytes = static_cast<const volatile uint8_t*>(sharedMemoryBlock->getData());
+    const size_t size = sharedMemoryBlock->getSize();
+    uint8_t sink = 0;
     
-    if (sharedData == nullptr)
-    {
-        sharedMemoryBlock.reset();
-        return false;
-    }
+    // 4 KiB é a menor página das plataformas suportadas
+    for (size_t offset = 0; offset < size; offset += 4096)
+        sink = static_cast<uint8_t>(sink + bytes[offset]);
     
-    initialized = true;
-    return true;
+    juce::ignoreUnused(sink);
 }
 
-bool SharedMemoryManager::readAudioData(juce::AudioBuffer<float>& buffer, int numSamples, float& latencyMs)
+int SharedMemoryManager::getProcessId()
 {
-    if (!initialized || sharedData == nullptr)
-        return false;
+#if JUCE_WINDOWS
+    return static_cast<int>(GetCurrentProcessId());
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+uint64_t SharedMemoryManager::getMonotonicNanoseconds()
+{
+#if JUCE_WINDOWS
+    static const int64_t frequency = []
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return static_cast<int64_t>(value.QuadPart);
+    }();
     
-    std::unique_lock<std::mutex> lock(accessMutex);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
     
-    // Verificar se há dados disponíveis
-    if (!sharedData->dataReady.load())
+    // Dividir em segundos e resto para não estourar 64 bits na multiplicação
+    const int64_t ticks = static_cast<int64_t>(counter.QuadPart);
+    return static_cast<uint64_t>((ticks / frequency) * 1000000000LL + ((ticks % frequency) * 1000000000LL) / frequency);
+#else
+    timespec now {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+bool SharedMemoryManager::isProcessAlive(int pid)
+{
+    if (pid <= 0)
         return false;
+
+#if JUCE_WINDOWS
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
     
-    const int bufferSize = sharedData->bufferSize.load();
-    if (bufferSize <= 0)
+    if (process == nullptr)
         return false;
     
-    // Calcular latência
-    uint64_t timestampNow = std::chrono::duration_cast<std::chrono::microseconds>(
-                            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    uint64_t timestampOld = sharedData->timestamp.load();
-    latencyMs = static_cast<float>(timestampNow - timestampOld) / 1000.0f;
+    const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+bool SharedMemoryManager::initialize()
+{
+    return initialize(Config());
+}
+
+bool SharedMemoryManager::initialize(const Config& config)
+{
+    const int requestedCapacity = juce::nextPowerOfTwo(juce::jlimit(AudioSharedData::minCapacityFrames,
+                                                                    AudioSharedData::maxCapacityFrames,
+                                                                    config.capacityFrames));
+    const int requestedChannels = juce::jlimit(1, AudioSharedData::maxChannels, config.numChannels);
+    const int requestedStreams = juce::jlimit(1, AudioSharedData::maxStreamsLimit, config.maxStreams);
+    const size_t requestedSize = AudioSharedData::getSegmentSize(requestedStreams, requestedCapacity, requestedChannels);
     
-    // Copiar dados para o buffer de áudio
-    int readPos = sharedData->readPosition.load();
+    readOnly = config.readOnly;
     
-    const int samplesToRead = juce::jmin(numSamples, bufferSize);
+    if (!openSegment(config, requestedSize))
+        return false;
     
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    if (sharedMemoryBlock->wasCreatedHere())
     {
-        float* channelData = buffer.getWritePointer(channel);
+        // Criamos o segmento: preencher o cabeçalho e a tabela de slots e publicá-los
+        // gravando o magic por último
+        new (sharedData) AudioSharedData();
+        
+        auto& header = sharedData->header;
+        header.creatorPid.store(getProcessId(), std::memory_order_relaxed);
+        header.layoutVersion = AudioSharedData::currentLayoutVersion;
+        header.maxStreams = static_cast<uint32_t>(requestedStreams);
+        header.capacityFrames = static_cast<uint32_t>(requestedCapacity);
+        header.numChannels = static_cast<uint32_t>(requestedChannels);
+        header.sampleFormat = static_cast<uint32_t>(SharedSampleFormat::Float32);
+        header.segmentSize = requestedSize;
+        header.slotsOffset = sizeof(AudioSharedData);
+        header.audioDataOffset = sizeof(AudioSharedData) + static_cast<uint64_t>(requestedStreams) * sizeof(StreamSlot);
+        
+        for (int streamId = 0; streamId < requestedStreams; ++streamId)
+            new (sharedData->getStreamSlot(streamId)) StreamSlot();
         
-        for (int i = 0; i < samplesToRead; ++i)
+        header.magic.store(AudioSharedData::expectedMagic, std::memory_order_release);
+    }
+    else
+    {
+        if (!readOnly && (static_cast<int>(sharedData->header.capacityFrames) != requestedCapacity
+                          || static_cast<int>(sharedData->header.numChannels) < requestedChannels))
         {
-            const int index = (readPos + i) % AudioSharedData::maxBufferSize;
-            channelData[i] = sharedData->audioData[index];
+            juce::Logger::writeToLog("Memoria compartilhada ja existe com "
+                                     + juce::String(static_cast<int>(sharedData->header.capacityFrames))
+                                     + " amostras e " + juce::String(static_cast<int>(sharedData->header.numChannels))
+                                     + " canais por stream; usando a configuracao existente");
         }
     }
     
-    // Atualizar posição de leitura
-    readPos = (readPos + samplesToRead) % AudioSharedData::maxBufferSize;
-    sharedData->readPosition.store(readPos);
-    
-    //
-    if (samplesToRead >= bufferSize) {
-        sharedData->dataReady.store(false);
-    } else {
-        sharedData->bufferSize.store(bufferSize - samplesToRead);
-    }
+    capacity = static_cast<int>(sharedData->header.capacityFrames);
+    capacityMask = static_cast<uint64_t>(capacity - 1);
+    slotChannels = static_cast<int>(sharedData->header.numChannels);
+    maxStreams = static_cast<int>(sharedData->header.maxStreams);
     
+    initialized = true;
+    applyMappingOptions(config);
     return true;
 }
 
-bool SharedMemoryManager::writeAudioData(const float* data, int numSamples)
+bool SharedMemoryManager::openSegment(const Config& config, size_t requestedSize)
 {
-    if (!initialized || sharedData == nullptr)
-        return false;
-    
-    std::unique_lock<std::mutex> lock(accessMutex);
+    // Criar/abrir memória compartilhada (somente abrir, no modo de leitura). Um segmento
+    // abandonado (criador morto antes de publicar o cabeçalho, ou layout de outra versão sem
+    // ninguém conectado) é removido e recriado; um removido enquanto o abríamos, reaberto
+    for (int attempt = 0; attempt < maxOpenAttempts; ++attempt)
+    {
+        sharedData = nullptr;
+        sharedMemoryBlock = std::make_unique<PlatformSharedMemory>(config, requestedSize);
+        
+        if (sharedMemoryBlock->wasRemovedWhileOpening())
+            continue;
+        
+        if (!sharedMemoryBlock->isValid())
+            break;
+        
+        sharedData = static_cast<AudioSharedData*>(sharedMemoryBlock->getData());
+        
+        if (sharedData == nullptr)
+            break;
+        
+        if (sharedMemoryBlock->wasCreatedHere())
+            return true;
+        
+        // Abrimos um segmento existente: esperar o criador publicar o cabeçalho
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        
+        while (sharedData->header.magic.load(std::memory_order_acquire) != AudioSharedData::expectedMagic
+               && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        
+        if (validateHeader(sharedMemoryBlock->getSize()))
+            return true;
+        
+        // A tabela de slots de outro layout não pode ser lida: as conexões desta versão seguram
+        // a trava compartilhada, e um cabeçalho não publicado ainda tem o PID de quem o cria
+        const bool published = sharedData->header.magic.load(std::memory_order_acquire) == AudioSharedData::expectedMagic;
+        
+        if (readOnly || !sharedMemoryBlock->tryLockExclusive()
+            || (!published && isProcessAlive(sharedData->header.creatorPid.load(std::memory_order_relaxed))))
+            break;
+        
+        juce::Logger::writeToLog("Memoria compartilhada abandonada ou de outra versao, sem processos conectados; recriando");
+        sharedMemoryBlock->unlink();
+    }
     
-    // Verificar se o buffer anterior já foi consumido antes de escrever novo dado
-    if (sharedData->dataReady.load()) {
-        // Se ainda há dados não processados, aguardar
-        return false;
+    sharedData = nullptr;
+    sharedMemoryBlock.reset();
+    return false;
+}
+
+bool SharedMemoryManager::hasLiveUsers() const
+{
+    for (int streamId = 0; streamId < maxStreams; ++streamId)
+    {
+        const auto& descriptor = sharedData->getStreamSlot(streamId)->descriptor;
+        const uint32_t state = descriptor.state.load(std::memory_order_acquire);
+        
+        // Em Claiming o ownerPid ainda é o do dono anterior: o registro em andamento conta como vivo
+        if (state == static_cast<uint32_t>(StreamState::Claiming)
+            || (state == static_cast<uint32_t>(StreamState::Active)
+                && isProcessAlive(descriptor.ownerPid.load(std::memory_order_relaxed))))
+            return true;
+        
+        const uint64_t token = descriptor.consumerToken.load(std::memory_order_acquire);
+        
+        if (token != 0 && isProcessAlive(static_cast<int>(token >> 32)))
+            return true;
     }
     
-    // Limitar ao tamanho máximo do buffer
-    const int samplesToWrite = juce::jmin(numSamples, AudioSharedData::maxBufferSize);
+    return false;
+}
 
-    // Guardar a taxa de amostragem original
-    sharedData->originalSampleRate.store(sharedData->sampleRate.load());
+void SharedMemoryManager::applyMappingOptions(const Config& config)
+{
+    mappingInfo = MappingInfo();
+    mappingInfo.size = sharedMemoryBlock->getSize();
+    mappingInfo.pageSize = sharedMemoryBlock->getPageSize();
+    mappingInfo.hugeTlb = sharedMemoryBlock->isHugeTlb();
+    mappingInfo.transparentHugePages = sharedMemoryBlock->hasTransparentHugePages();
+
+#if ! JUCE_LINUX
+    if (config.hugePages || config.numaNode >= 0)
+        juce::Logger::writeToLog("Paginas enormes e no NUMA so sao suportados no Linux; ignorados");
+#endif
+
+    if (config.lockPages)
+    {
+        mappingInfo.locked = sharedMemoryBlock->lock();
+        
+        if (!mappingInfo.locked)
+            juce::Logger::writeToLog("Nao foi possivel travar a memoria compartilhada; aumente o limite "
+                                     "memlock ou conceda CAP_IPC_LOCK. Seguindo so com a pre-carga");
+    }
     
-    // Copiar os dados
-    for (int i = 0; i < samplesToWrite; ++i) {
-        sharedData->audioData[i] = data[i];
+    // Travar já carrega as páginas; sem isso, tocá-las agora, fora da thread de áudio
+    if (mappingInfo.locked)
+    {
+        mappingInfo.prefaulted = true;
+    }
+    else if (config.prefault || config.lockPages)
+    {
+        prefault();
+        mappingInfo.prefaulted = true;
     }
     
-    // Registrar timestamp para medição de latência
-    sharedData->timestamp.store(std::chrono::duration_cast<std::chrono::microseconds>(
-                               std::chrono::high_resolution_clock::now().time_since_epoch()).count());
+    mappingInfo.numaNode = sharedMemoryBlock->getNumaNode();
     
-    // Atualizar posição de escrita e tamanho do buffer
-    sharedData->writePosition.store(0); // Sempre começa do zero
-    sharedData->bufferSize.store(samplesToWrite);
-    sharedData->readPosition.store(0); // Reset da posição de leitura
+    if (config.numaNode >= 0 && mappingInfo.numaNode != config.numaNode)
+        juce::Logger::writeToLog("Memoria compartilhada nao ficou no no NUMA " + juce::String(config.numaNode)
+                                 + " (no atual: " + juce::String(mappingInfo.numaNode) + ")");
     
-    // Marcar dados como prontos para leitura
-    sharedData->dataReady.store(true);
+    const juce::String pageKind = mappingInfo.hugeTlb ? "hugetlbfs"
+                                : (mappingInfo.transparentHugePages ? "comuns, THP pedido" : "comuns");
     
-    return true;
+    juce::Logger::writeToLog("Memoria compartilhada '" + juce::String(config.segmentName) + "': "
+                             + juce::String(static_cast<int64_t>(mappingInfo.size / 1024)) + " KiB, paginas de "
+                             + juce::String(static_cast<int64_t>(mappingInfo.pageSize / 1024)) + " KiB (" + pageKind
+                             + "), pre-carregada: " + (mappingInfo.prefaulted ? "sim" : "nao")
+                             + ", travada: " + (mappingInfo.locked ? "sim" : "nao")
+                             + ", no NUMA: " + (mappingInfo.numaNode >= 0 ? juce::String(mappingInfo.numaNode) : juce::String("?")));
 }
 
-void SharedMemoryManager::setSampleRate(double newSampleRate)
+bool SharedMemoryManager::validateHeader(size_t mappedSize) const
 {
-    if (initialized && sharedData != nullptr)
+    const auto& header = sharedData->header;
+    
+    if (header.magic.load(std::memory_order_acquire) != AudioSharedData::expectedMagic)
     {
-        std::unique_lock<std::mutex> lock(accessMutex);
-        sharedData->sampleRate.store(newSampleRate);
+        juce::Logger::writeToLog("Memoria compartilhada sem cabecalho valido (magic incorreto)");
+        return false;
     }
-}
-
-double SharedMemoryManager::getSampleRate() const
-{
-    if (initialized && sharedData != nullptr)
+    
+    if (header.layoutVersion != AudioSharedData::currentLayoutVersion)
+    {
+        juce::Logger::writeToLog("Versao de layout da memoria compartilhada incompativel: "
+                                 + juce::String(static_cast<int>(header.layoutVersion)));
+        return false;
+    }
+    
+    if (header.sampleFormat != static_cast<uint32_t>(SharedSampleFormat::Float32))
+    {
+        juce::Logger::writeToLog("Formato de amostra da memoria compartilhada nao suportado");
+        return false;
+    }
+    
+    const int headerCapacity = static_cast<int>(header.capacityFrames);
+    const int headerChannels = static_cast<int>(header.numChannels);
+    const int headerStreams = static_cast<int>(header.maxStreams);
+    
+    if (headerCapacity < AudioSharedData::minCapacityFrames || headerCapacity > AudioSharedData::maxCapacityFrames
+        || !juce::isPowerOfTwo(headerCapacity) || headerChannels < 1 || headerChannels > AudioSharedData::maxChannels
+        || headerStreams < 1 || headerStreams > AudioSharedData::maxStreamsLimit)
+    {
+        juce::Logger::writeToLog("Capacidade, canais ou numero de streams invalido no cabecalho da memoria compartilhada");
+        return false;
+    }
+    
+    // O segmento mapeado precisa conter tudo o que o cabeçalho promete
+    if (header.slotsOffset != sizeof(AudioSharedData)
+        || header.audioDataOffset != header.slotsOffset + static_cast<uint64_t>(headerStreams) * sizeof(StreamSlot)
+        || header.segmentSize != AudioSharedData::getSegmentSize(headerStreams, headerCapacity, headerChannels)
+        || header.segmentSize > mappedSize)
+    {
+        juce::Logger::writeToLog("Tamanho da memoria compartilhada inconsistente com o cabecalho");
+        return false;
+    }
+    
+    return true;
+}
+
+SharedMemoryManager::StreamInfo SharedMemoryManager::getStreamInfo(int streamId) const
+{
+    StreamInfo info;
+    
+    if (!initialized || sharedData == nullptr || streamId < 0 || streamId >= maxStreams)
+        return info;
+    
+    const auto& descriptor = sharedData->getStreamSlot(streamId)->descriptor;
+    
+    info.active = descriptor.state.load(std::memory_order_acquire) == static_cast<uint32_t>(StreamState::Active);
+    info.consumerAttached = descriptor.consumerToken.load(std::memory_order_relaxed) != 0;
+    info.numChannels = static_cast<int>(descriptor.numChannels.load(std::memory_order_relaxed));
+    info.ownerPid = descriptor.ownerPid.load(std::memory_order_relaxed);
+    
+    if (info.active)
+        info.name = std::string(descriptor.name, strnlen(descriptor.name, StreamSlot::maxNameLength));
+    
+    return info;
+}
+
+SharedMemoryManager::StreamCounters SharedMemoryManager::getStreamCounters(int streamId) const
+{
+    StreamCounters counters;
+    
+    if (!initialized || sharedData == nullptr || streamId < 0 || streamId >= maxStreams)
+        return counters;
+    
+    // Cada contador é lido isoladamente: o conjunto não é um instantâneo atômico, mas
+    // todos só crescem, então a diferença entre duas leituras é sempre válida
+    const auto* slot = sharedData->getStreamSlot(streamId);
+    
+    counters.framesWritten = slot->producer.writeIndex.load(std::memory_order_relaxed);
+    counters.framesRead = slot->consumer.readIndex.load(std::memory_order_relaxed);
+    counters.overruns = slot->producer.overruns.load(std::memory_order_relaxed);
+    counters.droppedFrames = slot->producer.droppedFrames.load(std::memory_order_relaxed);
+    counters.underruns = slot->consumer.underruns.load(std::memory_order_relaxed);
+    counters.concealedFrames = slot->consumer.concealedFrames.load(std::memory_order_relaxed);
+    counters.lostFrames = slot->consumer.lostFrames.load(std::memory_order_relaxed);
+    counters.repeatedFrames = slot->consumer.repeatedFrames.load(std::memory_order_relaxed);
+    counters.discardedFrames = slot->consumer.discardedFrames.load(std::memory_order_relaxed);
+    
+    return counters;
+}
+
+SharedMemoryManager::StreamTelemetry SharedMemoryManager::getStreamTelemetry(int streamId) const
+{
+    StreamTelemetry telemetry;
+    
+    if (!initialized || sharedData == nullptr || streamId < 0 || streamId >= maxStreams)
+        return telemetry;
+    
+    // Como os contadores, as faixas só crescem: percentis saem da diferença entre duas leituras
+    const auto* slot = sharedData->getStreamSlot(streamId);
+    
+    telemetry.reads = slot->consumerTelemetry.reads.load(std::memory_order_relaxed);
+    telemetry.fillAtRead = static_cast<int>(slot->consumerTelemetry.fillAtRead.load(std::memory_order_relaxed));
+    
+    for (int bucket = 0; bucket < StreamTelemetry::numBuckets; ++bucket)
+    {
+        telemetry.renderTime[bucket] = slot->producerTelemetry.renderTime.buckets[bucket].load(std::memory_order_relaxed);
+        telemetry.blockAge[bucket] = slot->consumerTelemetry.blockAge.buckets[bucket].load(std::memory_order_relaxed);
+        telemetry.callbackTime[bucket] = slot->consumerTelemetry.callbackTime.buckets[bucket].load(std::memory_order_relaxed);
+    }
+    
+    return telemetry;
+}
+
+int SharedMemoryManager::getTelemetryBucket(uint64_t durationNs)
+{
+    const uint64_t microseconds = durationNs / 1000;
+    
+    if (microseconds == 0)
+        return 0;
+    
+    const int bucket = 1 + juce::findHighestSetBit(static_cast<uint32_t>(juce::jmin(microseconds, static_cast<uint64_t>(0x7fffffff))));
+    return juce::jmin(bucket, StreamSlot::TelemetryHistogram::numBuckets - 1);
+}
+
+uint64_t SharedMemoryManager::getTelemetryBucketLimitNs(int bucket)
+{
+    return (static_cast<uint64_t>(1) << juce::jlimit(0, 62, bucket)) * 1000;
+}
+
+// Soma uma duração ao histograma. Cada histograma tem um único escritor, então carga e
+// armazenamento relaxados bastam e evitam a instrução com trava de um fetch_add
+static void addToHistogram(StreamSlot::TelemetryHistogram& histogram, uint64_t durationNs)
+{
+    auto& bucket = histogram.buckets[SharedMemoryManager::getTelemetryBucket(durationNs)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void SharedMemoryManager::recordCallbackTime(uint64_t startNs)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || isProducer)
+        return;
+    
+    const uint64_t now = getMonotonicNanoseconds();
+    addToHistogram(slot->consumerTelemetry.callbackTime, now > startNs ? now - startNs : 0);
+}
+
+int SharedMemoryManager::getNumChannels() const
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        const int streamChannels = static_cast<int>(slot->descriptor.numChannels.load(std::memory_order_relaxed));
+        
+        if (streamChannels > 0)
+            return juce::jmin(streamChannels, slotChannels);
+    }
+    
+    return slotChannels;
+}
+
+// Lê um carimbo do ring; falha se o produtor já o sobrescreveu ou está reescrevendo
+static bool readBlockStamp(const StreamSlot& slot, uint64_t sequence, SharedMemoryManager::BlockStamp& stamp)
+{
+    const auto& entry = slot.blockStamps.entries[sequence & (StreamSlot::blockStampCount - 1)];
+    
+    if (entry.sequence.load(std::memory_order_acquire) != sequence + 1)
+        return false;
+    
+    stamp.sequence = sequence;
+    stamp.startIndex = entry.startIndex.load(std::memory_order_relaxed);
+    stamp.sourceIndex = entry.sourceIndex.load(std::memory_order_relaxed);
+    stamp.timestampNs = entry.timestampNs.load(std::memory_order_relaxed);
+    stamp.numFrames = static_cast<int>(entry.numFrames.load(std::memory_order_relaxed));
+    
+    // Par com o fence do produtor: se o número ainda é o mesmo, os campos lidos são deste bloco
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return entry.sequence.load(std::memory_order_relaxed) == sequence + 1;
+}
+
+bool SharedMemoryManager::registerStream(int streamId, const std::string& name, int numChannels)
+{
+    if (!initialized || readOnly || sharedData == nullptr || streamId < 0 || streamId >= maxStreams)
+        return false;
+    
+    auto& descriptor = sharedData->getStreamSlot(streamId)->descriptor;
+    const int myPid = getProcessId();
+    
+    // Reivindicar o slot: livre, ou ativo em nome de um gerador que não existe mais. Um slot
+    // em Claiming nunca é tomado: o ownerPid só é gravado depois da reivindicação, então ali
+    // ainda é o do dono anterior e não diz nada sobre o registro em andamento
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    uint32_t state = descriptor.state.load(std::memory_order_acquire);
+    bool claimed = false;
+    
+    while (!claimed)
+    {
+        if (state == static_cast<uint32_t>(StreamState::Claiming))
+        {
+            // O outro registro leva microssegundos: esperar que termine ou desista
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                juce::Logger::writeToLog("Stream " + juce::String(streamId + 1) + " sendo registrado por outro processo");
+                return false;
+            }
+            
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            state = descriptor.state.load(std::memory_order_acquire);
+            continue;
+        }
+        
+        if (state == static_cast<uint32_t>(StreamState::Active))
+        {
+            const int owner = descriptor.ownerPid.load(std::memory_order_relaxed);
+            
+            if (isProcessAlive(owner))
+            {
+                juce::Logger::writeToLog("Stream " + juce::String(streamId + 1) + " ja registrado pelo processo "
+                                         + juce::String(owner));
+                return false;
+            }
+        }
+        
+        claimed = descriptor.state.compare_exchange_weak(state, static_cast<uint32_t>(StreamState::Claiming),
+                                                         std::memory_order_acq_rel);
+    }
+    
+    descriptor.ownerPid.store(myPid, std::memory_order_relaxed);
+    descriptor.numChannels.store(static_cast<uint32_t>(juce::jlimit(1, slotChannels, numChannels)),
+                                 std::memory_order_relaxed);
+    
+    const size_t nameLength = juce::jmin(name.size(), static_cast<size_t>(StreamSlot::maxNameLength - 1));
+    std::memset(descriptor.name, 0, sizeof(descriptor.name));
+    std::memcpy(descriptor.name, name.data(), nameLength);
+    
+    descriptor.generation.fetch_add(1, std::memory_order_relaxed);
+    descriptor.state.store(static_cast<uint32_t>(StreamState::Active), std::memory_order_release);
+    
+    auto* slot = sharedData->getStreamSlot(streamId);
+    cachedReadIndex = slot->consumer.readIndex.load(std::memory_order_acquire);
+    
+    // Continuar a linha do tempo da fonte do último bloco publicado no slot, para que a
+    // troca de gerador não apareça como buraco ou recuo para o consumidor
+    const uint64_t publishedBlocks = slot->producer.blockSequence.load(std::memory_order_acquire);
+    BlockStamp lastStamp;
+    
+    if (publishedBlocks > 0 && readBlockStamp(*slot, publishedBlocks - 1, lastStamp))
+        sourceIndex = lastStamp.sourceIndex + static_cast<uint64_t>(lastStamp.numFrames);
+    else
+        sourceIndex = slot->producer.writeIndex.load(std::memory_order_relaxed);
+    
+    isProducer = true;
+    currentStream.store(streamId, std::memory_order_release);
+    
+    return true;
+}
+
+void SharedMemoryManager::unregisterStream()
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer)
+        return;
+    
+    writeSeqLocked(slot->generatorControl, [](StreamSlot::GeneratorControlFields& fields)
+    {
+        fields.generatorActive.store(false, std::memory_order_relaxed);
+        fields.pullMode.store(false, std::memory_order_relaxed);
+        fields.freeRunning.store(false, std::memory_order_relaxed);
+        fields.targetFill.store(0, std::memory_order_relaxed);
+    });
+    
+    if (slot->descriptor.ownerPid.load(std::memory_order_relaxed) == getProcessId())
+    {
+        slot->descriptor.ownerPid.store(0, std::memory_order_relaxed);
+        slot->descriptor.state.store(static_cast<uint32_t>(StreamState::Free), std::memory_order_release);
+    }
+    
+    currentStream.store(-1, std::memory_order_release);
+    isProducer = false;
+}
+
+bool SharedMemoryManager::attachStream(int streamId)
+{
+    if (!initialized || readOnly || sharedData == nullptr || streamId < 0 || streamId >= maxStreams)
+        return false;
+    
+    const int previousStream = currentStream.load(std::memory_order_acquire);
+    
+    if (previousStream == streamId)
+        return true;
+    
+    // Cada stream tem um único consumidor: reivindicar o token do slot, tomando-o
+    // de volta apenas se o processo que o detinha não existe mais
+    static std::atomic<uint32_t> nextInstanceId { 1 };
+    
+    if (consumerToken == 0)
+        consumerToken = (static_cast<uint64_t>(static_cast<uint32_t>(getProcessId())) << 32)
+                      | nextInstanceId.fetch_add(1, std::memory_order_relaxed);
+    
+    auto& descriptor = sharedData->getStreamSlot(streamId)->descriptor;
+    uint64_t token = descriptor.consumerToken.load(std::memory_order_acquire);
+    bool claimed = false;
+    
+    while (!claimed)
+    {
+        if (token != 0 && token != consumerToken)
+        {
+            const int holder = static_cast<int>(token >> 32);
+            
+            if (isProcessAlive(holder))
+                return false;
+        }
+        
+        claimed = descriptor.consumerToken.compare_exchange_weak(token, consumerToken, std::memory_order_acq_rel);
+    }
+    
+    // Publicar o novo stream e esperar que a thread de áudio saia de uma leitura do
+    // stream antigo antes de liberá-lo (ordem seq_cst com readerBusy em readAudioData)
+    currentStream.store(streamId, std::memory_order_seq_cst);
+    
+    while (readerBusy.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+    
+    releaseConsumerToken(previousStream);
+    return true;
+}
+
+void SharedMemoryManager::detachStream()
+{
+    if (isProducer)
+        return;
+    
+    const int previousStream = currentStream.exchange(-1, std::memory_order_seq_cst);
+    
+    while (readerBusy.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+    
+    releaseConsumerToken(previousStream);
+}
+
+void SharedMemoryManager::releaseConsumerToken(int streamId)
+{
+    if (!initialized || sharedData == nullptr || streamId < 0 || streamId >= maxStreams || consumerToken == 0)
+        return;
+    
+    uint64_t expected = consumerToken;
+    sharedData->getStreamSlot(streamId)->descriptor.consumerToken.compare_exchange_strong(expected, 0,
+                                                                                        std::memory_order_acq_rel);
+}
+
+SharedMemoryManager::ReadRegion SharedMemoryManager::beginRead(int numSamples)
+{
+    ReadRegion region;
+    
+    // Marcar a leitura em andamento antes de carregar o stream atual, para que
+    // attachStream/detachStream não liberem o stream enquanto o usamos. commitRead
+    // encerra a seção
+    readerBusy.store(true, std::memory_order_seq_cst);
+    readingStream = -1;
+    reservedReadFrames = 0;
+    pullRequestFrames = 0;
+    
+    if (!initialized || sharedData == nullptr || numSamples <= 0)
+        return region;
+    
+    const int streamId = currentStream.load(std::memory_order_seq_cst);
+    
+    if (streamId < 0)
+        return region;
+    
+    auto* slot = sharedData->getStreamSlot(streamId);
+    readingStream = streamId;
+    
+    // Somente o consumidor escreve readIndex, então a leitura relaxada é suficiente;
+    // o acquire em writeIndex garante que as amostras publicadas já estão visíveis
+    const uint64_t readIdx = slot->consumer.readIndex.load(std::memory_order_relaxed);
+    
+    if (slot->generatorControl.pullMode.load(std::memory_order_relaxed))
+    {
+        // Modo pull: pedir exatamente o bloco deste callback (normalmente já pedido no
+        // callback anterior) e esperar por ele dentro do orçamento de espera ativa
+        pullRequestFrames = numSamples;
+        postDemand(*slot, readIdx + static_cast<uint64_t>(numSamples));
+        
+        if (pullSpinMicroseconds > 0)
+        {
+            const auto spinDeadline = std::chrono::steady_clock::now() + std::chrono::microseconds(pullSpinMicroseconds);
+            
+            while (slot->producer.writeIndex.load(std::memory_order_acquire) - readIdx < static_cast<uint64_t>(numSamples)
+                   && std::chrono::steady_clock::now() < spinDeadline)
+            {
+                cpuRelax();
+            }
+        }
+    }
+    
+    const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_acquire);
+    const uint64_t available = writeIdx - readIdx;
+    
+    if (available > static_cast<uint64_t>(capacity))
+    {
+        // Contadores inconsistentes (ex.: produtor reiniciado); descartar e ressincronizar.
+        // Se o produtor passou à frente, o que ficou para trás não será mais lido
+        if (writeIdx > readIdx)
+            slot->consumer.lostFrames.fetch_add(writeIdx - readIdx, std::memory_order_relaxed);
+        
+        nextCheckedSequence = 0;
+        slot->consumer.readIndex.store(writeIdx, std::memory_order_release);
+        ringSpaceDoorbell(*slot, 0);
+        return region;
+    }
+    
+    BRIDGE_TRACE_COUNTER("ringFill", static_cast<int64_t>(available));
+    
+    if (available == 0)
+        return region;
+    
+    const int position = static_cast<int>(readIdx & capacityMask);
+    
+    region.numFrames = static_cast<int>(juce::jmin(static_cast<uint64_t>(numSamples), available));
+    region.queuedFrames = static_cast<int>(available);
+    region.firstSize = juce::jmin(region.numFrames, capacity - position);
+    region.secondSize = region.numFrames - region.firstSize;
+    region.numChannels = juce::jlimit(1, slotChannels,
+                                      static_cast<int>(slot->descriptor.numChannels.load(std::memory_order_relaxed)));
+    
+    // Carimbos dos blocos lidos, para medir a idade das amostras
+    region.timing.readTimeNs = getMonotonicNanoseconds();
+    collectBlockStamps(*slot, readIdx, region.numFrames, region.timing);
+    checkContinuity(*slot, streamId, region.timing);
+    
+    // Telemetria: nível visto por esta leitura e idade do bloco mais antigo dela
+    auto& telemetry = slot->consumerTelemetry;
+    telemetry.reads.store(telemetry.reads.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    telemetry.fillAtRead.store(static_cast<uint32_t>(available), std::memory_order_relaxed);
+    
+    if (region.timing.numStamps > 0 && region.timing.readTimeNs > region.timing.stamps[0].timestampNs)
+        addToHistogram(telemetry.blockAge, region.timing.readTimeNs - region.timing.stamps[0].timestampNs);
+    
+    for (int channel = 0; channel < region.numChannels; ++channel)
+    {
+        const float* plane = sharedData->getChannelData(streamId, channel);
+        region.first[channel] = plane + position;
+        region.second[channel] = plane;
+    }
+    
+    queuedBeforeRead = available;
+    reservedReadFrames = region.numFrames;
+    return region;
+}
+
+void SharedMemoryManager::commitRead(int numSamples)
+{
+    struct ReaderSection
+    {
+        std::atomic<bool>& busy;
+        ~ReaderSection() { busy.store(false, std::memory_order_release); }
+    } readerSection { readerBusy };
+    
+    if (readingStream < 0)
+        return;
+    
+    auto* slot = sharedData->getStreamSlot(readingStream);
+    const int framesToCommit = juce::jlimit(0, reservedReadFrames, numSamples);
+    const uint64_t readIdx = slot->consumer.readIndex.load(std::memory_order_relaxed) + static_cast<uint64_t>(framesToCommit);
+    
+    readingStream = -1;
+    reservedReadFrames = 0;
+    
+    if (framesToCommit > 0)
+    {
+        // Liberar o espaço lido para o produtor
+        slot->consumer.readIndex.store(readIdx, std::memory_order_release);
+        BRIDGE_TRACE_INSTANT("ringRead", framesToCommit);
+        ringSpaceDoorbell(*slot, queuedBeforeRead - static_cast<uint64_t>(framesToCommit));
+    }
+    
+    // Modo pull: já pedir o bloco do próximo callback, que o gerador renderiza enquanto o host processa este
+    if (pullRequestFrames > 0)
+        postDemand(*slot, readIdx + static_cast<uint64_t>(pullRequestFrames));
+}
+
+int SharedMemoryManager::readAudioData(juce::AudioBuffer<float>& buffer, int numSamples, ReadTiming& timing, float gain)
+{
+    const auto region = beginRead(numSamples);
+    timing = region.timing;
+    
+    if (region.numFrames == 0)
+    {
+        commitRead(0);
+        return 0;
+    }
+    
+    // Copiar dados para o buffer de áudio, canal a canal: no máximo dois trechos
+    // contíguos por canal, sem aritmética de índice por amostra
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        float* channelData = buffer.getWritePointer(channel);
+        
+        if (region.numChannels > 1 && channel >= region.numChannels)
+        {
+            // Canal de saída sem correspondente no ring
+            juce::FloatVectorOperations::clear(channelData, region.numFrames);
+            continue;
+        }
+        
+        const int plane = region.numChannels == 1 ? 0 : channel;
+        
+        // O ring só transporta Float32 (validado no cabeçalho), então a conversão de
+        // formato se reduz a uma cópia, com o ganho aplicado na mesma passada
+        if (gain == 1.0f)
+        {
+            juce::FloatVectorOperations::copy(channelData, region.first[plane], region.firstSize);
+            juce::FloatVectorOperations::copy(channelData + region.firstSize, region.second[plane], region.secondSize);
+        }
+        else
+        {
+            juce::FloatVectorOperations::copyWithMultiply(channelData, region.first[plane], gain, region.firstSize);
+            juce::FloatVectorOperations::copyWithMultiply(channelData + region.firstSize, region.second[plane], gain,
+                                                          region.secondSize);
+        }
+    }
+    
+    commitRead(region.numFrames);
+    return region.numFrames;
+}
+
+int SharedMemoryManager::skipFrames(int numSamples)
+{
+    const auto region = beginRead(numSamples);
+    auto* slot = readingStream >= 0 ? sharedData->getStreamSlot(readingStream) : nullptr;
+    
+    if (slot != nullptr && region.numFrames > 0)
+        slot->consumer.discardedFrames.fetch_add(static_cast<uint64_t>(region.numFrames), std::memory_order_relaxed);
+    
+    commitRead(region.numFrames);
+    return region.numFrames;
+}
+
+void SharedMemoryManager::reportUnderrun(int concealedFrames, bool newEvent)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || isProducer)
+        return;
+    
+    // Somente o consumidor escreve estes contadores
+    if (newEvent)
+        slot->consumer.underruns.fetch_add(1, std::memory_order_relaxed);
+    
+    if (concealedFrames > 0)
+        slot->consumer.concealedFrames.fetch_add(static_cast<uint64_t>(concealedFrames), std::memory_order_relaxed);
+}
+
+void SharedMemoryManager::ringSpaceDoorbell(StreamSlot& slot, uint64_t queuedFrames)
+{
+    auto& doorbell = slot.doorbell;
+    
+    // Par com o fence de waitForSpace: ou o produtor vê o novo readIndex antes de
+    // dormir, ou nós vemos producerWaiting e o acordamos
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if (doorbell.producerWaiting.load(std::memory_order_acquire) == 0
+        || queuedFrames > doorbell.lowWaterMark.load(std::memory_order_relaxed))
+        return;
+    
+    // Um único toque por espera: o produtor volta a marcar producerWaiting se dormir de novo
+    ringSharedDoorbell(doorbell.spaceSequence, doorbell.producerWaiting);
+}
+
+void SharedMemoryManager::postDemand(StreamSlot& slot, uint64_t demandIndex)
+{
+    // A demanda só avança; pedir de novo o que já foi pedido não toca a campainha
+    if (demandIndex <= slot.consumer.demandIndex.load(std::memory_order_relaxed))
+        return;
+    
+    slot.consumer.demandIndex.store(demandIndex, std::memory_order_release);
+    
+    // Par com o fence de waitForDemand
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if (slot.doorbell.requestWaiting.load(std::memory_order_acquire) != 0)
+        ringSharedDoorbell(slot.doorbell.requestSequence, slot.doorbell.requestWaiting);
+}
+
+void SharedMemoryManager::collectBlockStamps(const StreamSlot& slot, uint64_t startIndex, int numFrames, ReadTiming& timing)
+{
+    timing.startIndex = startIndex;
+    timing.numFrames = numFrames;
+    timing.numStamps = 0;
+    
+    if (numFrames <= 0)
+        return;
+    
+    // Voltar a partir do bloco mais recente até o bloco que contém startIndex
+    const uint64_t endIndex = startIndex + static_cast<uint64_t>(numFrames);
+    const uint64_t newestSequence = slot.producer.blockSequence.load(std::memory_order_acquire);
+    uint64_t firstSequence = newestSequence;
+    BlockStamp stamp;
+    
+    for (int i = 0; i < StreamSlot::blockStampCount && firstSequence > 0; ++i)
+    {
+        if (!readBlockStamp(slot, firstSequence - 1, stamp) || stamp.startIndex + static_cast<uint64_t>(stamp.numFrames) <= startIndex)
+            break;
+        
+        --firstSequence;
+    }
+    
+    // E seguir em ordem, guardando os blocos que se sobrepõem à leitura
+    for (uint64_t sequence = firstSequence; sequence < newestSequence && timing.numStamps < ReadTiming::maxStamps; ++sequence)
+    {
+        if (!readBlockStamp(slot, sequence, stamp) || stamp.startIndex >= endIndex)
+            break;
+        
+        timing.stamps[timing.numStamps++] = stamp;
+    }
+}
+
+void SharedMemoryManager::checkContinuity(StreamSlot& slot, int streamId, const ReadTiming& timing)
+{
+    // Outro stream: nada do que foi verificado vale para este
+    if (streamId != continuityStream)
+    {
+        continuityStream = streamId;
+        nextCheckedSequence = 0;
+    }
+    
+    for (int i = 0; i < timing.numStamps; ++i)
+    {
+        const auto& stamp = timing.stamps[i];
+        
+        // Cada bloco é verificado uma única vez, na primeira leitura que o alcança
+        if (stamp.sequence < nextCheckedSequence)
+            continue;
+        
+        // Só é possível comparar com o bloco imediatamente anterior; se carimbos foram
+        // sobrescritos antes de serem vistos, recomeçar a partir deste bloco
+        if (nextCheckedSequence > 0 && stamp.sequence == nextCheckedSequence)
+        {
+            if (stamp.sourceIndex > expectedSourceIndex)
+                slot.consumer.lostFrames.fetch_add(stamp.sourceIndex - expectedSourceIndex, std::memory_order_relaxed);
+            else if (stamp.sourceIndex < expectedSourceIndex)
+                slot.consumer.repeatedFrames.fetch_add(expectedSourceIndex - stamp.sourceIndex, std::memory_order_relaxed);
+        }
+        
+        nextCheckedSequence = stamp.sequence + 1;
+        expectedSourceIndex = stamp.sourceIndex + static_cast<uint64_t>(stamp.numFrames);
+    }
+}
+
+void SharedMemoryManager::setPullSpinBudget(int microseconds)
+{
+    pullSpinMicroseconds = juce::jmax(0, microseconds);
+}
+
+int SharedMemoryManager::getNumSamplesAvailable() const
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr)
+        return 0;
+    
+    const uint64_t readIdx = slot->consumer.readIndex.load(std::memory_order_acquire);
+    const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_acquire);
+    
+    return static_cast<int>(juce::jmin(writeIdx - readIdx, static_cast<uint64_t>(capacity)));
+}
+
+SharedMemoryManager::WriteRegion SharedMemoryManager::beginWrite(int numSamples)
+{
+    WriteRegion region;
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer || numSamples <= 0)
+        return region;
+    
+    const int streamId = currentStream.load(std::memory_order_relaxed);
+    
+    // Somente o produtor escreve writeIndex; o acquire em readIndex garante que o
+    // consumidor terminou de ler as posições que vamos sobrescrever
+    const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_relaxed);
+    const uint64_t ringSize = static_cast<uint64_t>(capacity);
+    
+    uint64_t used = writeIdx - cachedReadIndex;
+    
+    if (used + static_cast<uint64_t>(numSamples) > ringSize)
+    {
+        // Pela cópia local não cabe tudo: reler o índice do consumidor
+        cachedReadIndex = slot->consumer.readIndex.load(std::memory_order_acquire);
+        used = writeIdx - cachedReadIndex;
+    }
+    
+    if (used >= ringSize)
+        return region; // Ring cheio (ou contadores inconsistentes, que o consumidor ressincroniza)
+    
+    const int freeSpace = capacity - static_cast<int>(used);
+    const int position = static_cast<int>(writeIdx & capacityMask);
+    
+    region.numFrames = juce::jmin(numSamples, freeSpace);
+    region.firstSize = juce::jmin(region.numFrames, capacity - position);
+    region.secondSize = region.numFrames - region.firstSize;
+    region.numChannels = getNumChannels();
+    
+    for (int channel = 0; channel < region.numChannels; ++channel)
+    {
+        float* plane = sharedData->getChannelData(streamId, channel);
+        region.first[channel] = plane + position;
+        region.second[channel] = plane;
+    }
+    
+    reservedFrames = region.numFrames;
+    writeBeginNs = getMonotonicNanoseconds();
+    return region;
+}
+
+void SharedMemoryManager::commitWrite(int numSamples)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer)
+        return;
+    
+    // Não é possível publicar mais do que foi reservado por beginWrite
+    const int framesToCommit = juce::jlimit(0, reservedFrames, numSamples);
+    reservedFrames = 0;
+    
+    if (framesToCommit == 0)
+        return;
+    
+    // Guardar a taxa de amostragem original (somente quando a configuração do host muda,
+    // para não sujar a linha de controle do gerador a cada bloco)
+    const auto hostControl = getHostControl();
+    
+    if (hostControl.changeCount != lastHostChangeCount)
+    {
+        lastHostChangeCount = hostControl.changeCount;
+        writeSeqLocked(slot->generatorControl, [&hostControl](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.originalSampleRate.store(hostControl.sampleRate, std::memory_order_relaxed);
+        });
+    }
+    
+    const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_relaxed);
+    
+    // Carimbar o bloco antes de publicá-lo: quem vê as amostras também vê o carimbo. O número
+    // zerado marca o carimbo como incompleto enquanto os campos são reescritos
+    const uint64_t sequence = slot->producer.blockSequence.load(std::memory_order_relaxed);
+    auto& stamp = slot->blockStamps.entries[sequence & (StreamSlot::blockStampCount - 1)];
+    
+    const uint64_t now = getMonotonicNanoseconds();
+    
+    stamp.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    stamp.startIndex.store(writeIdx, std::memory_order_relaxed);
+    stamp.timestampNs.store(now, std::memory_order_relaxed);
+    stamp.sourceIndex.store(sourceIndex, std::memory_order_relaxed);
+    stamp.numFrames.store(static_cast<uint32_t>(framesToCommit), std::memory_order_relaxed);
+    stamp.sequence.store(sequence + 1, std::memory_order_release);
+    slot->producer.blockSequence.store(sequence + 1, std::memory_order_release);
+    sourceIndex += static_cast<uint64_t>(framesToCommit);
+    
+    // Publicar as amostras para o consumidor
+    slot->producer.writeIndex.store(writeIdx + static_cast<uint64_t>(framesToCommit), std::memory_order_release);
+    BRIDGE_TRACE_INSTANT("ringWrite", framesToCommit);
+    
+    addToHistogram(slot->producerTelemetry.renderTime, now > writeBeginNs ? now - writeBeginNs : 0);
+}
+
+int SharedMemoryManager::writeAudioData(const float* const* channelData, int numSourceChannels, int numSamples)
+{
+    if (numSourceChannels <= 0)
+        return 0;
+    
+    const auto region = beginWrite(numSamples);
+    
+    if (region.numFrames == 0)
+        return 0;
+    
+    // Copiar os dados, canal a canal, nos até dois trechos contíguos da região
+    for (int channel = 0; channel < region.numChannels; ++channel)
+    {
+        const float* source = nullptr;
+        
+        if (numSourceChannels == 1)
+            source = channelData[0];
+        else if (channel < numSourceChannels)
+            source = channelData[channel];
+        
+        if (source != nullptr)
+        {
+            juce::FloatVectorOperations::copy(region.first[channel], source, region.firstSize);
+            juce::FloatVectorOperations::copy(region.second[channel], source + region.firstSize, region.secondSize);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear(region.first[channel], region.firstSize);
+            juce::FloatVectorOperations::clear(region.second[channel], region.secondSize);
+        }
+    }
+    
+    commitWrite(region.numFrames);
+    return region.numFrames;
+}
+
+void SharedMemoryManager::reportOverrun(int droppedFrames)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer || droppedFrames <= 0)
+        return;
+    
+    // Somente o produtor escreve estes contadores
+    slot->producer.overruns.fetch_add(1, std::memory_order_relaxed);
+    slot->producer.droppedFrames.fetch_add(static_cast<uint64_t>(droppedFrames), std::memory_order_relaxed);
+    sourceIndex += static_cast<uint64_t>(droppedFrames);
+}
+
+int SharedMemoryManager::getFreeSpace() const
+{
+    if (getCurrentSlot() == nullptr)
+        return 0;
+    
+    return capacity - getNumSamplesAvailable();
+}
+
+bool SharedMemoryManager::waitForSpace(int lowWaterMark, int timeoutMs)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer)
+        return false;
+    
+    const uint64_t mark = static_cast<uint64_t>(juce::jlimit(0, capacity, lowWaterMark));
+    slot->doorbell.lowWaterMark.store(static_cast<uint32_t>(mark), std::memory_order_relaxed);
+    
+    return spinThenWait(slot->doorbell.spaceSequence, slot->doorbell.producerWaiting,
+                        waitSpinMicroseconds, timeoutMs, [slot, mark]
+                        {
+                            const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_relaxed);
+                            const uint64_t readIdx = slot->consumer.readIndex.load(std::memory_order_acquire);
+                            return writeIdx - readIdx <= mark;
+                        });
+}
+
+int SharedMemoryManager::getDemand() const
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr)
+        return 0;
+    
+    // Quadros pedidos pelo consumidor além do que já foi escrito, limitados ao espaço livre
+    const uint64_t writeIdx = slot->producer.writeIndex.load(std::memory_order_relaxed);
+    const uint64_t demandIdx = slot->consumer.demandIndex.load(std::memory_order_acquire);
+    const uint64_t readIdx = slot->consumer.readIndex.load(std::memory_order_acquire);
+    
+    if (demandIdx <= writeIdx || writeIdx - readIdx >= static_cast<uint64_t>(capacity))
+        return 0;
+    
+    const uint64_t freeSpace = static_cast<uint64_t>(capacity) - (writeIdx - readIdx);
+    return static_cast<int>(juce::jmin(demandIdx - writeIdx, freeSpace));
+}
+
+int SharedMemoryManager::waitForDemand(int timeoutMs)
+{
+    auto* slot = getCurrentSlot();
+    
+    if (slot == nullptr || !isProducer)
+        return 0;
+    
+    spinThenWait(slot->doorbell.requestSequence, slot->doorbell.requestWaiting,
+                 waitSpinMicroseconds, timeoutMs, [this] { return getDemand() > 0; });
+    
+    return getDemand();
+}
+
+void SharedMemoryManager::interruptWait()
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        for (auto* sequence : { &slot->doorbell.spaceSequence, &slot->doorbell.requestSequence })
+        {
+            sequence->fetch_add(1, std::memory_order_release);
+            wakeSharedWord(*sequence);
+        }
+    }
+}
+
+void SharedMemoryManager::setHostConfiguration(double newSampleRate, int newBlockSize)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->hostControl, [=](StreamSlot::HostControlFields& fields)
+        {
+            fields.sampleRate.store(newSampleRate, std::memory_order_relaxed);
+            fields.hostBlockSize.store(newBlockSize, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setTransportPlaying(bool isPlaying)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->hostControl, [=](StreamSlot::HostControlFields& fields)
+        {
+            fields.transportPlaying.store(isPlaying, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setFrequency(float newFrequency)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->generatorControl, [=](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.frequency.store(newFrequency, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setGeneratorActive(bool active)
+{
+    if (auto* slot = getCurrentSlot())
     {
-        return sharedData->sampleRate.load();
+        writeSeqLocked(slot->generatorControl, [=](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.generatorActive.store(active, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setPullMode(bool shouldPull)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->generatorControl, [=](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.pullMode.store(shouldPull, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setFreeRunning(bool isFreeRunning)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->generatorControl, [=](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.freeRunning.store(isFreeRunning, std::memory_order_relaxed);
+        });
+    }
+}
+
+void SharedMemoryManager::setTargetFill(int frames)
+{
+    if (auto* slot = getCurrentSlot())
+    {
+        writeSeqLocked(slot->generatorControl, [=](StreamSlot::GeneratorControlFields& fields)
+        {
+            fields.targetFill.store(frames, std::memory_order_relaxed);
+        });
+    }
+}
+
+bool SharedMemoryManager::isPullMode() const
+{
+    return getGeneratorControl().pullMode;
+}
+
+SharedMemoryManager::HostControl SharedMemoryManager::getHostControl() const
+{
+    HostControl control;
+    
+    if (auto* slot = getCurrentSlot())
+    {
+        control.changeCount = readSeqLocked(slot->hostControl, [&control](const StreamSlot::HostControlFields& fields)
+        {
+            control.sampleRate = fields.sampleRate.load(std::memory_order_relaxed);
+            control.hostBlockSize = fields.hostBlockSize.load(std::memory_order_relaxed);
+            control.transportPlaying = fields.transportPlaying.load(std::memory_order_relaxed);
+        });
+    }
+    
+    return control;
+}
+
+SharedMemoryManager::GeneratorControl SharedMemoryManager::getGeneratorControl() const
+{
+    GeneratorControl control;
+    
+    if (auto* slot = getCurrentSlot())
+    {
+        control.changeCount = readSeqLocked(slot->generatorControl, [&control](const StreamSlot::GeneratorControlFields& fields)
+        {
+            control.originalSampleRate = fields.originalSampleRate.load(std::memory_order_relaxed);
+            control.frequency = fields.frequency.load(std::memory_order_relaxed);
+            control.active = fields.generatorActive.load(std::memory_order_relaxed);
+            control.pullMode = fields.pullMode.load(std::memory_order_relaxed);
+            control.freeRunning = fields.freeRunning.load(std::memory_order_relaxed);
+            control.targetFill = fields.targetFill.load(std::memory_order_relaxed);
+        });
+        
+        control.active = control.active
+                      && slot->descriptor.state.load(std::memory_order_acquire) == static_cast<uint32_t>(StreamState::Active);
     }
     
-    return 44100.0; // valor padrão
+    return control;
 }
\ No newline at end of file
@@ -2,91 +2,602 @@
 
 #include "JuceHeader.h"
 #include <atomic>
+#include <cstddef>
 #include <chrono>
 #include <string>
-#include <mutex>
+
+// Formatos de amostra suportados no ring
+enum class SharedSampleFormat : uint32_t {
+    Float32 = 1
+};
 
 // Definição da estrutura de dados na memória compartilhada
-struct AudioSharedData {
-    static constexpr int maxBufferSize = 16384;  
-    
-    std::atomic<int> readPosition { 0 };
-    std::atomic<int> writePosition { 0 };
-    std::atomic<bool> dataReady { false };
-    std::atomic<int> bufferSize { 0 };
-    std::atomic<double> sampleRate { 44100.0 };
-    std::atomic<double> originalSampleRate { 44100.0 }; 
-    std::atomic<uint64_t> timestamp { 0 }; 
-    std::atomic<float> frequency { 440.0f }; 
-    std::atomic<bool> generatorActive { false };  
-    float audioData[maxBufferSize];
+//
+// Um único segmento contém um diretório de streams: um cabeçalho global, uma
+// tabela fixa de maxStreams slots (StreamSlot) e, em seguida, a área de
+// amostras de cada slot. O ID de um stream é o índice do seu slot, então os
+// deslocamentos do ring de cada stream são fixos e conhecidos pelos dois lados.
+// Um gerador registra um stream reivindicando o slot (estado, PID do dono,
+// nome, canais); cada instância do plugin se conecta ao slot que escolheu.
+//
+// O segmento começa com um cabeçalho (magic, versão do layout, número de slots,
+// capacidade, canais por slot e formato de amostra) que quem cria o segmento
+// preenche e publica por último, gravando o magic com release. Quem abre o
+// segmento lê o tamanho real do objeto, espera o magic e valida o cabeçalho
+// antes de usar os rings, de forma que os binários não precisam concordar em
+// tempo de compilação sobre a capacidade.
+//
+// O áudio de cada stream é transportado por um ring buffer SPSC (um produtor,
+// um consumidor). writeIndex e readIndex são contadores monotônicos de 64 bits
+// que nunca são zerados: a quantidade de amostras disponíveis é
+// writeIndex - readIndex e a posição física no ring é índice & (capacidade - 1).
+// O produtor publica com release em writeIndex e o consumidor libera espaço com
+// release em readIndex, de forma que nenhuma trava é necessária entre os processos.
+//
+// Layout: em cada slot, o descritor, os campos escritos pelo produtor, os
+// campos escritos pelo consumidor e os campos de controle (raramente alterados)
+// ficam cada um em sua própria linha de cache, para que uma escrita de um lado
+// não invalide a linha que o outro lado usa. Usamos 128 bytes porque o
+// prefetcher de linha adjacente dos x86 busca pares de linhas de 64 bytes. As
+// amostras são planares (um plano de capacityFrames amostras por canal) e cada
+// plano começa em um limite alinhado para cargas AVX, já que a capacidade é
+// potência de dois e pelo menos minCapacityFrames.
+//
+// Espera por espaço: em vez de dormir em intervalos fixos, o produtor gira
+// brevemente e depois dorme na campainha (doorbell) do slot, um futex
+// compartilhado entre os processos no Linux. O consumidor toca a campainha
+// quando o nível do ring cai até a marca informada pelo produtor, e só faz a
+// chamada de sistema quando há um produtor esperando.
+//
+// Modo pull (opcional, escolhido pelo gerador): em vez de manter o ring alguns
+// blocos à frente, o gerador renderiza exatamente o que o plugin pede. A cada
+// callback o plugin publica em demandIndex até onde quer ler e toca a campainha
+// de pedidos; o gerador renderiza demandIndex - writeIndex quadros. O plugin
+// pede o bloco do próximo callback logo após ler o atual e, se ele ainda não
+// chegou, espera ativamente dentro de um orçamento curto, de forma que a
+// latência da ponte fica em torno de um bloco do host.
+//
+// Controle: a configuração do host (escrita pelo plugin) e o estado do gerador
+// (escrito pelo gerador) ficam em dois blocos separados, cada um protegido por
+// um seqlock. O escritor torna o contador ímpar, grava os campos e o torna par
+// de novo; o leitor repete a leitura se o contador mudou ou estava ímpar. Assim
+// a thread de áudio lê um instantâneo consistente sem nunca bloquear, e o
+// contador serve também de contador de mudanças.
+//
+// Carimbos de bloco: cada bloco publicado pelo produtor ganha um número de
+// sequência, o índice absoluto da sua primeira amostra e o instante da
+// publicação no relógio monotônico (CLOCK_MONOTONIC em ns, comum aos dois
+// processos), gravados em um pequeno ring de carimbos do slot. Ao ler, o
+// consumidor recolhe os carimbos dos blocos que a leitura cobre e pode
+// calcular a idade real de cada amostra no momento em que ela toca.
+//
+// Continuidade: além do índice no ring, cada carimbo leva a posição do bloco
+// na linha do tempo da fonte (sourceIndex). O produtor avança essa posição
+// também pelos quadros que descartou (reportOverrun), de forma que o
+// consumidor detecta, ao ler, buracos (quadros perdidos) e recuos (quadros
+// repetidos) entre blocos consecutivos. Os contadores acumulados de cada lado
+// (overruns e quadros descartados pelo produtor; underruns, quadros ocultados,
+// perdidos, repetidos e descartados pelo consumidor) ficam no slot e nunca são
+// zerados, para que uma ferramenta externa diferencie a falta de dados do
+// produtor de um consumidor parado sem anexar um depurador.
+//
+// Telemetria: cada lado mantém no slot, com atômicos relaxados e sem travas,
+// histogramas logarítmicos (faixas de potências de dois em microssegundos) do
+// tempo de renderização de cada bloco (produtor, de beginWrite a commitWrite),
+// da idade do bloco mais antigo no momento da leitura e da duração do callback
+// do host (consumidor), além do nível do ring visto na última leitura. Uma
+// ferramenta de monitoramento abre o segmento somente para leitura
+// (Config::readOnly) e calcula as taxas e percentis pela diferença entre
+// duas leituras.
 
+// Estados de um slot de stream
+enum class StreamState : uint32_t {
+    Free = 0,       // nenhum gerador registrado
+    Claiming = 1,   // um gerador está preenchendo o descritor
+    Active = 2      // descritor válido, gerador registrado
 };
 
+struct StreamSlot {
+    static constexpr size_t cacheLineSize = 128;
+    static constexpr int maxNameLength = 64;
+    
+    // Descritor do stream: escrito pelo gerador ao registrar e pelo plugin ao se conectar
+    struct alignas(cacheLineSize) Descriptor {
+        std::atomic<uint32_t> state { 0 };            // StreamState
+        std::atomic<uint32_t> generation { 0 };       // incrementado a cada novo registro
+        std::atomic<int32_t> ownerPid { 0 };          // processo do gerador registrado
+        std::atomic<uint32_t> numChannels { 0 };      // canais publicados pelo gerador (<= canais do slot)
+        std::atomic<uint64_t> consumerToken { 0 };    // PID << 32 | instância do plugin conectado (0 = livre)
+        char name[maxNameLength] = {};                // nome legível do stream (terminado em zero)
+    };
+    
+    // Configuração do host: escrita pelo plugin (seqlock), raramente
+    struct alignas(cacheLineSize) HostControlFields {
+        std::atomic<uint64_t> sequence { 0 };         // seqlock: contador nos 32 bits baixos (ímpar durante
+                                                      // uma escrita) e PID do escritor nos 32 altos
+        std::atomic<double> sampleRate { 44100.0 };
+        std::atomic<int> hostBlockSize { 0 };         // tamanho de bloco do host
+        std::atomic<bool> transportPlaying { false }; // reprodução ligada no plugin
+    };
+    
+    // Estado do gerador: escrito pelo gerador (seqlock), raramente
+    struct alignas(cacheLineSize) GeneratorControlFields {
+        std::atomic<uint64_t> sequence { 0 };         // seqlock: como em HostControlFields
+        std::atomic<double> originalSampleRate { 44100.0 };
+        std::atomic<float> frequency { 440.0f };
+        std::atomic<bool> generatorActive { false };
+        std::atomic<bool> pullMode { false };         // gerador renderiza sob demanda (demandIndex)
+        std::atomic<bool> freeRunning { false };      // gerador segue o próprio relógio (o plugin compensa a deriva)
+        std::atomic<int> targetFill { 0 };            // nível médio que o gerador mantém no ring (modo push)
+    };
+    
+    // Campos escritos apenas pelo produtor (a cada bloco)
+    struct alignas(cacheLineSize) ProducerFields {
+        std::atomic<uint64_t> writeIndex { 0 };
+        std::atomic<uint64_t> blockSequence { 0 };    // blocos publicados (o próximo carimbo)
+        std::atomic<uint64_t> overruns { 0 };         // vezes em que o ring cheio fez o produtor descartar dados
+        std::atomic<uint64_t> droppedFrames { 0 };    // quadros da fonte descartados nesses overruns
+    };
+    
+    // Carimbo de um bloco publicado. sequence vale o número do bloco + 1 quando o carimbo está
+    // completo e 0 enquanto o produtor o reescreve, de forma que o leitor detecta sobrescritas
+    struct BlockStampEntry {
+        std::atomic<uint64_t> sequence { 0 };
+        std::atomic<uint64_t> startIndex { 0 };       // índice absoluto da primeira amostra do bloco
+        std::atomic<uint64_t> timestampNs { 0 };      // publicação, relógio monotônico
+        std::atomic<uint64_t> sourceIndex { 0 };      // posição do bloco na linha do tempo da fonte
+        std::atomic<uint32_t> numFrames { 0 };
+    };
+    
+    // Ring dos carimbos dos últimos blocos: escrito apenas pelo produtor
+    static constexpr int blockStampCount = 128;       // potência de dois
+    
+    struct alignas(cacheLineSize) BlockStampFields {
+        BlockStampEntry entries[blockStampCount];
+    };
+    
+    // Campos escritos apenas pelo consumidor (a cada callback do host)
+    struct alignas(cacheLineSize) ConsumerFields {
+        std::atomic<uint64_t> readIndex { 0 };
+        std::atomic<uint64_t> demandIndex { 0 };      // modo pull: índice até onde o consumidor quer ler
+        std::atomic<uint64_t> underruns { 0 };        // callbacks em que faltaram dados
+        std::atomic<uint64_t> concealedFrames { 0 };  // quadros preenchidos pela ocultação
+        std::atomic<uint64_t> lostFrames { 0 };       // buracos na linha do tempo da fonte vistos ao ler
+        std::atomic<uint64_t> repeatedFrames { 0 };   // recuos na linha do tempo da fonte vistos ao ler
+        std::atomic<uint64_t> discardedFrames { 0 };  // quadros lidos e jogados fora pelo consumidor
+    };
+    
+    // Campainha: escrita apenas quando o produtor vai dormir ou é acordado
+    struct alignas(cacheLineSize) DoorbellFields {
+        std::atomic<uint32_t> spaceSequence { 0 };    // palavra do futex, incrementada a cada toque
+        std::atomic<uint32_t> producerWaiting { 0 };  // 1 enquanto o produtor espera (ou está prestes a dormir)
+        std::atomic<uint32_t> lowWaterMark { 0 };     // nível do ring (amostras) que acorda o produtor
+        std::atomic<uint32_t> requestSequence { 0 };  // modo pull: palavra do futex dos pedidos do consumidor
+        std::atomic<uint32_t> requestWaiting { 0 };   // 1 enquanto o produtor espera um pedido
+    };
+    
+    // Histograma logarítmico de durações: a faixa 0 conta valores abaixo de 1 µs e a faixa
+    // k >= 1, valores em [2^(k-1), 2^k) µs; a última faixa acumula tudo acima
+    struct TelemetryHistogram {
+        static constexpr int numBuckets = 24;
+        std::atomic<uint64_t> buckets[numBuckets] {};
+    };
+    
+    // Telemetria escrita apenas pelo produtor (a cada bloco)
+    struct alignas(cacheLineSize) ProducerTelemetryFields {
+        TelemetryHistogram renderTime;                // de beginWrite a commitWrite
+    };
+    
+    // Telemetria escrita apenas pelo consumidor (a cada callback do host)
+    struct alignas(cacheLineSize) ConsumerTelemetryFields {
+        std::atomic<uint64_t> reads { 0 };            // leituras com dados
+        std::atomic<uint32_t> fillAtRead { 0 };       // quadros enfileirados na última leitura
+        TelemetryHistogram blockAge;                  // idade do bloco mais antigo ao ser lido
+        TelemetryHistogram callbackTime;              // duração do callback do host
+    };
+    
+    Descriptor descriptor;
+    HostControlFields hostControl;
+    GeneratorControlFields generatorControl;
+    ProducerFields producer;
+    ConsumerFields consumer;
+    DoorbellFields doorbell;
+    BlockStampFields blockStamps;
+    ProducerTelemetryFields producerTelemetry;
+    ConsumerTelemetryFields consumerTelemetry;
+};
+
+struct AudioSharedData {
+    static constexpr uint32_t expectedMagic = 0x4C4C4142;    // "BALL" em little-endian
+    static constexpr uint32_t currentLayoutVersion = 14;     // incrementar a cada mudança de layout
+    static constexpr size_t cacheLineSize = StreamSlot::cacheLineSize;
+    static constexpr int defaultCapacityFrames = 16384;
+    static constexpr int minCapacityFrames = 64;
+    static constexpr int maxCapacityFrames = 1 << 20;
+    static constexpr int maxChannels = 16;                   // até 7.1.4 / 16 canais discretos
+    static constexpr int defaultMaxStreams = 64;
+    static constexpr int maxStreamsLimit = 256;
+    
+    // Cabeçalho: preenchido uma única vez por quem cria o segmento
+    struct alignas(cacheLineSize) SegmentHeader {
+        std::atomic<uint32_t> magic { 0 };        // gravado por último (release)
+        uint32_t layoutVersion = 0;
+        uint32_t maxStreams = 0;                  // número de slots na tabela
+        uint32_t capacityFrames = 0;              // capacidade do ring de cada slot (potência de dois)
+        uint32_t numChannels = 0;                 // planos reservados por slot
+        uint32_t sampleFormat = 0;                // SharedSampleFormat
+        uint64_t segmentSize = 0;                 // tamanho total do segmento em bytes
+        uint64_t slotsOffset = 0;                 // deslocamento da tabela de slots
+        uint64_t audioDataOffset = 0;             // deslocamento da área de amostras
+        std::atomic<int32_t> creatorPid { 0 };    // quem criou o segmento (um cabeçalho não publicado de um processo morto foi abandonado)
+    };
+    
+    SegmentHeader header;
+    
+    // Tamanho total do segmento para a configuração informada
+    static size_t getSegmentSize(int maxStreams, int capacityFrames, int numChannels)
+    {
+        return sizeof(AudioSharedData)
+             + static_cast<size_t>(maxStreams) * sizeof(StreamSlot)
+             + static_cast<size_t>(maxStreams) * static_cast<size_t>(capacityFrames)
+                 * static_cast<size_t>(numChannels) * sizeof(float);
+    }
+    
+    StreamSlot* getStreamSlot(int streamId)
+    {
+        return reinterpret_cast<StreamSlot*>(reinterpret_cast<char*>(this) + header.slotsOffset) + streamId;
+    }
+    
+    // Plano de amostras de um canal de um stream: os streams ficam em sequência,
+    // cada um com numChannels planos de capacityFrames amostras
+    float* getChannelData(int streamId, int channel)
+    {
+        const size_t planeIndex = static_cast<size_t>(streamId) * header.numChannels + static_cast<size_t>(channel);
+        
+        return reinterpret_cast<float*>(reinterpret_cast<char*>(this) + header.audioDataOffset)
+             + planeIndex * header.capacityFrames;
+    }
+};
+
+static_assert (offsetof(StreamSlot, hostControl) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, generatorControl) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, producer) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, consumer) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, doorbell) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, blockStamps) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, producerTelemetry) % StreamSlot::cacheLineSize == 0
+               && offsetof(StreamSlot, consumerTelemetry) % StreamSlot::cacheLineSize == 0
+               && sizeof(StreamSlot) % StreamSlot::cacheLineSize == 0,
+               "Descritor, controle, produtor, consumidor e campainha precisam começar em linhas de cache distintas");
+static_assert (sizeof(StreamSlot::Descriptor) == StreamSlot::cacheLineSize
+               && sizeof(StreamSlot::HostControlFields) == StreamSlot::cacheLineSize
+               && sizeof(StreamSlot::GeneratorControlFields) == StreamSlot::cacheLineSize
+               && sizeof(StreamSlot::ProducerFields) == StreamSlot::cacheLineSize
+               && sizeof(StreamSlot::ConsumerFields) == StreamSlot::cacheLineSize
+               && sizeof(StreamSlot::DoorbellFields) == StreamSlot::cacheLineSize
+               && sizeof(AudioSharedData) == AudioSharedData::cacheLineSize,
+               "Cada grupo de campos deve ocupar exatamente uma linha de cache");
+static_assert ((StreamSlot::blockStampCount & (StreamSlot::blockStampCount - 1)) == 0
+               && sizeof(StreamSlot::BlockStampFields) % StreamSlot::cacheLineSize == 0,
+               "O ring de carimbos precisa ter tamanho potência de dois e ocupar linhas de cache inteiras");
+static_assert (sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+               "A palavra da campainha é usada diretamente como futex");
+
 class SharedMemoryManager
 {
 public:
+    // Configuração usada apenas quando este processo cria o segmento; quem
+    // apenas abre um segmento existente adota o que está no cabeçalho
+    struct Config {
+        int capacityFrames = AudioSharedData::defaultCapacityFrames;  // arredondado para potência de dois
+        int numChannels = 2;                                           // planos por slot, 1 a AudioSharedData::maxChannels
+        int maxStreams = AudioSharedData::defaultMaxStreams;          // slots na tabela de streams
+        bool readOnly = false;      // apenas abrir um segmento existente, sem escrever nele (monitoramento)
+        std::string segmentName = defaultSegmentName;   // vale também ao abrir: outro nome é outra ponte (ex.: benchmark)
+        
+        // Mapeamento. hugePages vale para quem cria (quem abre acha o segmento nos dois
+        // lugares); as demais opções valem para o mapeamento de cada processo
+        bool hugePages = false;     // arquivo no hugetlbfs; sem ele, THP do shmem (MADV_HUGEPAGE)
+        bool prefault = true;       // carregar as páginas ao conectar, e não no primeiro acesso da thread de áudio
+        bool lockPages = false;     // travar o segmento na memória (mlock)
+        int numaNode = -1;          // nó NUMA das páginas (-1 = política do sistema)
+        std::string hugePageDirectory = "/dev/hugepages";  // ponto de montagem do hugetlbfs
+    };
+    
+    // O que o mapeamento obteve de fato (também escrito no log ao conectar)
+    struct MappingInfo {
+        size_t size = 0;
+        size_t pageSize = 0;                // tamanho de página do segmento
+        bool hugeTlb = false;               // segmento no hugetlbfs
+        bool transparentHugePages = false;  // MADV_HUGEPAGE aceito (efeito depende de shmem_enabled)
+        bool prefaulted = false;
+        bool locked = false;
+        int numaNode = -1;                  // nó da primeira página (-1 = desconhecido)
+    };
+    
+    static constexpr const char* defaultSegmentName = "LowLatencyAudioPluginSharedMemory";
+    
+    // Instantâneos consistentes dos blocos de controle. changeCount é incrementado a
+    // cada escrita do bloco, para detectar mudanças sem comparar campo a campo
+    struct HostControl {
+        double sampleRate = 44100.0;
+        int hostBlockSize = 0;
+        bool transportPlaying = false;
+        uint32_t changeCount = 0;
+    };
+    
+    struct GeneratorControl {
+        double originalSampleRate = 44100.0;
+        float frequency = 440.0f;
+        bool active = false;        // gerador ativo e stream registrado
+        bool pullMode = false;
+        bool freeRunning = false;
+        int targetFill = 0;         // quadros enfileirados em média (0 se o gerador não mantém um nível)
+        uint32_t changeCount = 0;
+    };
+    
+    // Descrição de um slot do diretório, para listar streams na interface
+    struct StreamInfo {
+        bool active = false;
+        bool consumerAttached = false;
+        int numChannels = 0;
+        int ownerPid = 0;
+        std::string name;
+    };
+    
     SharedMemoryManager();
     ~SharedMemoryManager();
-
+    
     bool initialize();
+    bool initialize(const Config& config);
     bool isInitialized() const { return initialized; }
+    bool isReadOnly() const { return readOnly; }
+    
+    // Lê uma vez cada página do segmento mapeado, para que as faltas de página aconteçam
+    // agora e não na primeira passagem da thread de tempo real pelo ring (nada é escrito)
+    void prefault() const;
+    
+    MappingInfo getMappingInfo() const { return mappingInfo; }
+    int getCapacity() const { return capacity; }
+    int getMaxStreams() const { return maxStreams; }
+    StreamInfo getStreamInfo(int streamId) const;
+    
+    // Stream ao qual este gerenciador está ligado (registrado como produtor ou conectado como consumidor), ou -1
+    int getCurrentStream() const { return currentStream.load(std::memory_order_acquire); }
+    int getNumChannels() const;
     
     // Para o plugin VST (cliente)
-    bool readAudioData(juce::AudioBuffer<float>& buffer, int numSamples, float& latencyMs);
+    // Conecta este consumidor ao stream informado (chamar fora da thread de áudio).
+    // Falha se outra instância viva já estiver consumindo o mesmo stream
+    bool attachStream(int streamId);
+    void detachStream();
+    
+    // Carimbo de um bloco publicado: número do bloco, índice absoluto da primeira amostra,
+    // posição na linha do tempo da fonte, tamanho e instante da publicação
+    // (getMonotonicNanoseconds do produtor)
+    struct BlockStamp {
+        uint64_t sequence = 0;
+        uint64_t startIndex = 0;
+        uint64_t sourceIndex = 0;
+        uint64_t timestampNs = 0;
+        int numFrames = 0;
+    };
+    
+    // Momento de uma leitura e os carimbos dos blocos que ela cobre, em ordem. Se a leitura
+    // cobrir mais de maxStamps blocos, só os primeiros são devolvidos; blocos cujo carimbo já
+    // foi sobrescrito ficam de fora
+    struct ReadTiming {
+        static constexpr int maxStamps = 32;
+        uint64_t startIndex = 0;    // índice absoluto da primeira amostra lida
+        uint64_t readTimeNs = 0;    // relógio monotônico no momento da leitura
+        int numFrames = 0;          // quadros consumidos pela leitura
+        int numStamps = 0;
+        BlockStamp stamps[maxStamps];
+    };
+    
+    // Contadores acumulados de um stream (nunca zerados; compare duas leituras). Do lado do
+    // produtor, overruns indicam um consumidor que parou de ler; do lado do consumidor,
+    // underruns sem overruns indicam um produtor que não entregou a tempo
+    struct StreamCounters {
+        uint64_t framesWritten = 0;     // writeIndex
+        uint64_t framesRead = 0;        // readIndex
+        uint64_t overruns = 0;
+        uint64_t droppedFrames = 0;
+        uint64_t underruns = 0;
+        uint64_t concealedFrames = 0;
+        uint64_t lostFrames = 0;
+        uint64_t repeatedFrames = 0;
+        uint64_t discardedFrames = 0;
+    };
+    
+    // Leitura dos contadores de qualquer slot, sem precisar estar ligado a ele
+    StreamCounters getStreamCounters(int streamId) const;
+    
+    // Telemetria acumulada de um stream (ver StreamSlot::TelemetryHistogram para as faixas)
+    struct StreamTelemetry {
+        static constexpr int numBuckets = StreamSlot::TelemetryHistogram::numBuckets;
+        uint64_t reads = 0;
+        int fillAtRead = 0;
+        uint64_t renderTime[numBuckets] = {};
+        uint64_t blockAge[numBuckets] = {};
+        uint64_t callbackTime[numBuckets] = {};
+    };
+    
+    StreamTelemetry getStreamTelemetry(int streamId) const;
+    
+    // Faixa do histograma de telemetria de uma duração, e o limite superior (exclusivo) da faixa
+    static int getTelemetryBucket(uint64_t durationNs);
+    static uint64_t getTelemetryBucketLimitNs(int bucket);
+    
+    // Registra a duração de um callback do host iniciado em startNs (getMonotonicNanoseconds)
+    void recordCallbackTime(uint64_t startNs);
+    
+    // Relógio monotônico comum aos processos da máquina (CLOCK_MONOTONIC no Linux e no macOS,
+    // QueryPerformanceCounter no Windows), em nanossegundos
+    static uint64_t getMonotonicNanoseconds();
+    
+    // PID deste processo
+    static int getProcessId();
+    
+    // Se o processo ainda existe (também usado para recuperar escritas de processos mortos)
+    static bool isProcessAlive(int pid);
+    
+    // Região do ring devolvida por beginRead, no mesmo formato de WriteRegion: por canal,
+    // first[ch] com firstSize quadros e, se a região dá a volta no ring, second[ch] com secondSize
+    struct ReadRegion {
+        int numFrames = 0;      // firstSize + secondSize (0 se não houver dados)
+        int firstSize = 0;
+        int secondSize = 0;
+        int numChannels = 0;    // canais do stream
+        int queuedFrames = 0;   // quadros enfileirados no ring antes desta leitura
+        ReadTiming timing;      // carimbos dos blocos da região
+        const float* first[AudioSharedData::maxChannels] = {};
+        const float* second[AudioSharedData::maxChannels] = {};
+    };
+    
+    // Leitura sem cópia (thread de áudio): beginRead devolve até numSamples quadros disponíveis
+    // para processamento direto na memória compartilhada, e commitRead libera os primeiros
+    // numSamples deles. Toda chamada a beginRead deve ser seguida de commitRead, mesmo com 0:
+    // enquanto isso o stream não pode ser trocado. Em modo pull, beginRead também publica o
+    // pedido de bloco e espera até o orçamento de setPullSpinBudget
+    ReadRegion beginRead(int numSamples);
+    void commitRead(int numSamples);
+    
+    // Lê até numSamples amostras do ring, multiplicadas por gain, e retorna quantas foram lidas
+    // (leitura parcial permitida). O canal N do ring vai para o canal N do buffer; um ring mono
+    // é copiado para todos os canais e canais de saída sem correspondente no ring são zerados.
+    // timing recebe os carimbos dos blocos lidos
+    int readAudioData(juce::AudioBuffer<float>& buffer, int numSamples, ReadTiming& timing, float gain = 1.0f);
+    
+    // Descarta até numSamples quadros enfileirados sem lê-los (ex.: excesso acumulado
+    // enquanto o consumidor esteve parado) e retorna quantos foram descartados
+    int skipFrames(int numSamples);
+    
+    // Informa um underrun do consumidor: concealedFrames quadros do callback foram
+    // preenchidos pela ocultação. newEvent marca o início de uma nova falha (thread de áudio)
+    void reportUnderrun(int concealedFrames, bool newEvent);
+    void setPullSpinBudget(int microseconds);
+    int getNumSamplesAvailable() const;
+    
+    // Configuração do host para o gerador (fora da thread de áudio)
+    void setHostConfiguration(double newSampleRate, int newBlockSize);
+    void setTransportPlaying(bool isPlaying);
     
     // Para a aplicação externa (servidor)
-    bool writeAudioData(const float* data, int numSamples);
-    void setSampleRate(double newSampleRate);
-    double getSampleRate() const;
-
-    // Métodos para frequência
-    void setFrequency(float newFrequency) {
-        if (initialized && sharedData != nullptr) {
-            std::unique_lock<std::mutex> lock(accessMutex);
-            sharedData->frequency.store(newFrequency);
-        }
-    }
+    // Registra este produtor no slot streamId. Falha se outro gerador vivo já for dono do slot
+    bool registerStream(int streamId, const std::string& name, int numChannels);
+    void unregisterStream();
     
-    float getFrequency() const {
-        if (initialized && sharedData != nullptr) {
-            return sharedData->frequency.load();
-        }
-        return 440.0f; // valor padrão
-    }
-
-    // Métodos para indicar status do gerador
-    void setGeneratorActive(bool active) {
-        if (initialized && sharedData != nullptr) {
-            std::unique_lock<std::mutex> lock(accessMutex);
-            sharedData->generatorActive.store(active);
-        }
-    }
+    // Região do ring reservada por beginWrite. Por canal, a região é formada por até dois
+    // trechos contíguos do plano: first[ch] com firstSize quadros e, quando a região dá a
+    // volta no ring, second[ch] (início do plano) com secondSize quadros
+    struct WriteRegion {
+        int numFrames = 0;      // firstSize + secondSize (0 se o ring estiver cheio)
+        int firstSize = 0;
+        int secondSize = 0;
+        int numChannels = 0;    // canais do stream
+        float* first[AudioSharedData::maxChannels] = {};
+        float* second[AudioSharedData::maxChannels] = {};
+    };
     
-    bool isGeneratorActive() const {
-        if (initialized && sharedData != nullptr) {
-            return sharedData->generatorActive.load();
-        }
-        return false;
-    }
+    // Escrita sem cópia: beginWrite reserva até numSamples quadros livres e devolve os trechos
+    // do ring para o produtor renderizar diretamente na memória compartilhada; commitWrite
+    // publica os primeiros numSamples quadros reservados (pode ser menos que o reservado)
+    WriteRegion beginWrite(int numSamples);
+    void commitWrite(int numSamples);
+    
+    // Escreve até numSamples amostras no ring e retorna quantas couberam (escrita parcial permitida).
+    // Uma fonte mono é replicada em todos os canais do ring; canais do ring sem fonte recebem silêncio
+    int writeAudioData(const float* const* channelData, int numSourceChannels, int numSamples);
+    int getFreeSpace() const;
+    
+    // Informa que droppedFrames quadros da fonte foram descartados por falta de espaço no
+    // ring: conta um overrun e avança a linha do tempo da fonte, para que o consumidor veja
+    // o buraco no próximo bloco
+    void reportOverrun(int droppedFrames);
     
+    // Espera até que o ring tenha no máximo lowWaterMark amostras enfileiradas: gira por
+    // waitSpinMicroseconds e depois dorme na campainha do slot. Retorna true se a condição
+    // foi atingida, false no timeout ou quando interruptWait() acorda a espera
+    bool waitForSpace(int lowWaterMark, int timeoutMs);
+    void interruptWait();
+    
+    // Modo pull: o gerador renderiza apenas os quadros pedidos pelo consumidor.
+    // waitForDemand espera um pedido (mesma política de waitForSpace) e retorna
+    // quantos quadros escrever, já limitados ao espaço livre
+    void setPullMode(bool shouldPull);
+    void setFreeRunning(bool isFreeRunning);
+    void setTargetFill(int frames);
+    bool isPullMode() const;
+    int getDemand() const;
+    int waitForDemand(int timeoutMs);
+    
+    void setFrequency(float newFrequency);
+    void setGeneratorActive(bool active);
+    
+    // Leituras sem bloqueio, seguras na thread de áudio
+    HostControl getHostControl() const;
+    GeneratorControl getGeneratorControl() const;
+    
+    int getHostBlockSize() const { return getHostControl().hostBlockSize; }
+    double getSampleRate() const { return getHostControl().sampleRate; }
+    float getFrequency() const { return getGeneratorControl().frequency; }
+    bool isGeneratorActive() const { return getGeneratorControl().active; }
+
 private:
     // Implementação multiplataforma de memória compartilhada
     class PlatformSharedMemory {
     public:
-        PlatformSharedMemory(const std::string& name, size_t size);
+        // size é usado apenas ao criar; ao abrir um segmento existente, o tamanho real é lido do objeto
+        // readOnly abre apenas um objeto existente, mapeado somente para leitura
+        // Além do nome e do modo, usa de config as opções de páginas enormes e de nó NUMA,
+        // aplicadas antes do primeiro acesso às páginas
+        PlatformSharedMemory(const Config& config, size_t size);
         ~PlatformSharedMemory();
         
         void* getData() { return data; }
+        size_t getSize() const { return memSize; }
         bool isValid() const { return isCreated; }
+        bool wasCreatedHere() const { return isOwner; }
+        bool isHugeTlb() const { return hugeTlb; }
+        bool hasTransparentHugePages() const { return transparentHugePages; }
+        size_t getPageSize() const { return pageSize; }
+        
+        // Trava as páginas do mapeamento na memória (e com isso as carrega)
+        bool lock();
+        
+        // Nó NUMA da primeira página, ou -1
+        int getNumaNode() const;
+        
+        // Remove o nome do objeto (o último processo a sair do segmento chama isto)
+        void unlink();
         
+        // Cada conexão de escrita segura uma trava compartilhada (flock) no objeto, que o
+        // sistema solta quando o processo morre. Obter a exclusiva prova que nenhuma outra
+        // conexão está aberta; sem suporte a flock (shm do macOS) retorna true e a decisão
+        // fica com a tabela de slots
+        bool tryLockExclusive();
+        
+        // O nome foi removido por quem saiu entre abrirmos e travarmos o objeto: abrir de novo
+        bool wasRemovedWhileOpening() const { return removedWhileOpening; }
+    
     private:
+    #if JUCE_LINUX
+        void createHugeTlbSegment(const std::string& path, size_t size);
+        void applyPlacement(const Config& config);
+    #endif
+    
         std::string memoryName;
+        std::string hugeTlbPath;    // arquivo no hugetlbfs, se o segmento está lá
         void* data;
         size_t memSize;
         bool isCreated;
         bool isOwner;
-
+        bool hugeTlb = false;
+        bool transparentHugePages = false;
+        bool removedWhileOpening = false;
+        size_t pageSize = 4096;
+    
     #if JUCE_WINDOWS
         void* fileHandle;
         void* mapHandle;
@@ -98,8 +609,78 @@ private:
     std::unique_ptr<PlatformSharedMemory> sharedMemoryBlock;
     AudioSharedData* sharedData;
     bool initialized;
-    std::mutex accessMutex;
+    bool readOnly = false;
+    MappingInfo mappingInfo;
+    
+    // Cópias locais do cabeçalho validado (o cabeçalho não muda após a criação)
+    int capacity = 0;
+    int slotChannels = 0;
+    int maxStreams = 0;
+    uint64_t capacityMask = 0;
+    
+    // Stream ligado a este gerenciador. O plugin pode trocar de stream pela thread de
+    // mensagens enquanto a thread de áudio lê: readerBusy marca uma leitura em andamento
+    // para que o stream antigo só seja liberado depois que a thread de áudio o abandonar
+    std::atomic<int> currentStream { -1 };
+    std::atomic<bool> readerBusy { false };
+    bool isProducer = false;
+    uint64_t consumerToken = 0;
+    
+    // Cópia local de readIndex usada pelo produtor: a linha do consumidor só é
+    // relida quando a cópia local indica que não há espaço suficiente
+    uint64_t cachedReadIndex = 0;
+    int reservedFrames = 0;     // quadros reservados pelo último beginWrite
+    uint64_t writeBeginNs = 0;  // instante do último beginWrite (tempo de renderização)
+    uint32_t lastHostChangeCount = 0;   // última configuração do host vista pelo produtor
+    uint64_t sourceIndex = 0;           // posição do próximo bloco na linha do tempo da fonte
+    
+    // Orçamento de espera ativa do consumidor em modo pull (microssegundos)
+    int pullSpinMicroseconds = 0;
+    
+    // Estado da leitura entre beginRead e commitRead (somente a thread de áudio usa)
+    int readingStream = -1;
+    int reservedReadFrames = 0;
+    int pullRequestFrames = 0;
+    uint64_t queuedBeforeRead = 0;
+    
+    // Verificação de continuidade (somente a thread de áudio): próximo bloco a verificar
+    // e a posição da fonte em que ele deveria começar
+    int continuityStream = -1;
+    uint64_t nextCheckedSequence = 0;
+    uint64_t expectedSourceIndex = 0;
+    
+    StreamSlot* getCurrentSlot() const
+    {
+        const int streamId = currentStream.load(std::memory_order_acquire);
+        return (initialized && sharedData != nullptr && streamId >= 0) ? sharedData->getStreamSlot(streamId) : nullptr;
+    }
+    
+    // Toca a campainha se o produtor espera e o nível chegou à marca dele (thread de áudio)
+    void ringSpaceDoorbell(StreamSlot& slot, uint64_t queuedFrames);
+    
+    // Publica um pedido do consumidor (modo pull) e acorda o produtor se ele espera
+    void postDemand(StreamSlot& slot, uint64_t demandIndex);
+    
+    // Carimbos dos blocos que cobrem [startIndex, startIndex + numFrames), em ordem (thread de áudio)
+    static void collectBlockStamps(const StreamSlot& slot, uint64_t startIndex, int numFrames, ReadTiming& timing);
+    
+    // Compara cada bloco ainda não verificado com o fim do anterior na linha do tempo da
+    // fonte e acumula buracos e recuos nos contadores do consumidor (thread de áudio)
+    void checkContinuity(StreamSlot& slot, int streamId, const ReadTiming& timing);
+    
+    bool validateHeader(size_t mappedSize) const;
+    
+    // Abre ou cria o segmento em sharedMemoryBlock/sharedData; ao abrir um existente, só
+    // retorna true com o cabeçalho publicado e validado
+    bool openSegment(const Config& config, size_t requestedSize);
+    static constexpr int maxOpenAttempts = 3;
+    
+    // Algum gerador ou consumidor vivo na tabela de slots (ou um registro em andamento)
+    bool hasLiveUsers() const;
+    
+    // Carrega e trava o segmento conforme config e escreve no log o que foi obtido
+    void applyMappingOptions(const Config& config);
+    void releaseConsumerToken(int streamId);
     
-    static constexpr const char* sharedMemoryName = "LowLatencyAudioPluginSharedMemory";
-    static constexpr int sharedMemorySize = sizeof(AudioSharedData);
+    static constexpr int waitSpinMicroseconds = 20;
 };
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Gravador de eventos para diagnóstico (modo de instrumentação opcional)
+//
+// Compilado com BRIDGE_TRACE=1 (opção BRIDGE_TRACE do CMake), cada ponto
+// instrumentado grava um evento com o instante no relógio monotônico comum aos
+// processos (SharedMemoryManager::getMonotonicNanoseconds) em um ring da própria
+// thread: sem travas e sem alocação, já que os rings são reservados em
+// initialise() (um por núcleo mais extraThreads) e cada thread reivindica o seu
+// com um único fetch_add. Os rings guardam os eventos mais recentes (o mais
+// antigo é sobrescrito); os eventos de threads que chegam depois do último ring
+// são contados, e o total aparece como rótulo do processo no trace. Ao final, os
+// eventos são escritos no formato JSON de trace do Chrome, que o Perfetto e o
+// chrome://tracing abrem; como o relógio é o mesmo nos dois processos, os
+// arquivos do gerador e do plugin podem ser juntados (BridgeStat --merge-traces)
+// para ver os dois lado a lado em uma única linha do tempo.
+//
+// O gravador é do processo: várias instâncias do plugin num mesmo host dividem os
+// rings. Cada uma chama initialise() e finish(); só a última a sair escreve o
+// arquivo, depois de parar a gravação. Como instâncias podem dividir as threads
+// do host, cada evento leva a faixa (setTrack) de quem o gravou, e a exportação
+// separa as faixas em linhas próprias.
+//
+// Sem BRIDGE_TRACE, as macros abaixo não geram código.
+class TraceRecorder
+{
+public:
+    enum class EventType : uint8_t {
+        Begin,      // início de um trecho (par com End na mesma thread)
+        End,
+        Instant,    // evento pontual, com um valor (ex.: quadros)
+        Counter     // valor de uma grandeza ao longo do tempo (ex.: nível do ring)
+    };
+    
+    // Registra um usuário do gravador e, no primeiro, reserva os rings de eventos
+    // (chamar fora da thread de áudio)
+    static void initialise(const char* processName, int eventsPerThread = defaultEventsPerThread);
+    static bool isActive();
+    
+    // Libera um usuário registrado em initialise(). O último para a gravação e escreve
+    // os eventos em path; os demais só retornam false
+    static bool finish(const std::string& path);
+    
+    // Nome da thread atual no trace (mantém o primeiro nome dado)
+    static void setThreadName(const char* name);
+    
+    // Faixa dos próximos eventos da thread atual (ex.: a instância do plugin que está
+    // usando a thread do host agora); 0 = sem faixa
+    static void setTrack(int track) noexcept;
+    
+    // Grava um evento na thread atual. name precisa ser um literal (só o ponteiro é guardado)
+    static void record(EventType type, const char* name, int64_t value = 0) noexcept;
+    
+    // Escreve os eventos gravados no formato de trace do Chrome. Chamar quando as
+    // threads instrumentadas estiverem paradas: eventos gravados durante a escrita
+    // podem sair incompletos (finish() para a gravação antes de chamar)
+    static bool writeChromeTrace(const std::string& path);
+    
+    // BRIDGE_TRACE_DIR, ou o diretório temporário, com bridge-trace-<processo>-<pid>.json
+    static std::string getDefaultTracePath();
+    
+    // Trecho com início e fim no escopo atual
+    class Scope
+    {
+    public:
+        explicit Scope(const char* scopeName) noexcept : name(scopeName) { record(EventType::Begin, name); }
+        ~Scope() { record(EventType::End, name); }
+    
+    private:
+        const char* name;
+    };
+    
+    static constexpr int defaultEventsPerThread = 1 << 17;   // ~1 min de callbacks de 128 amostras
+    static constexpr int extraThreads = 8;                   // além de hardware_concurrency(): mensagens, I/O, host
+};
+
+#if BRIDGE_TRACE
+ #define BRIDGE_TRACE_JOIN_IMPL(a, b) a##b
+ #define BRIDGE_TRACE_JOIN(a, b) BRIDGE_TRACE_JOIN_IMPL(a, b)
+ #define BRIDGE_TRACE_INITIALISE(processName) TraceRecorder::initialise(processName)
+ #define BRIDGE_TRACE_THREAD_NAME(name) TraceRecorder::setThreadName(name)
+ #define BRIDGE_TRACE_TRACK(track) TraceRecorder::setTrack(track)
+ #define BRIDGE_TRACE_SCOPE(name) TraceRecorder::Scope BRIDGE_TRACE_JOIN(bridgeTraceScope, __LINE__) (name)
+ #define BRIDGE_TRACE_INSTANT(name, value) TraceRecorder::record(TraceRecorder::EventType::Instant, name, value)
+ #define BRIDGE_TRACE_COUNTER(name, value) TraceRecorder::record(TraceRecorder::EventType::Counter, name, value)
+ #define BRIDGE_TRACE_WRITE() TraceRecorder::finish(TraceRecorder::getDefaultTracePath())
+#else
+ #define BRIDGE_TRACE_INITIALISE(processName)
+ #define BRIDGE_TRACE_THREAD_NAME(name)
+ #define BRIDGE_TRACE_TRACK(track)
+ #define BRIDGE_TRACE_SCOPE(name)
+ #define BRIDGE_TRACE_INSTANT(name, value)
+ #define BRIDGE_TRACE_COUNTER(name, value)
+ #define BRIDGE_TRACE_WRITE()
+#endif
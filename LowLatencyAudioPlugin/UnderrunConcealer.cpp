@@ -0,0 +1,284 @@
+#include "UnderrunConcealer.h"
+#include <cmath>
+
+// Produto escalar com oito somas parciais independentes, para o compilador vetorizar
+// (uma soma única em float é uma cadeia de dependências que ele não pode reordenar)
+static float dotProduct(const float* a, const float* b, int numSamples)
+{
+    float sums[8] = {};
+    int i = 0;
+    
+    for (; i + 8 <= numSamples; i += 8)
+        for (int lane = 0; lane < 8; ++lane)
+            sums[lane] += a[i + lane] * b[i + lane];
+    
+    float result = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+    
+    for (; i < numSamples; ++i)
+        result += a[i] * b[i];
+    
+    return result;
+}
+
+void UnderrunConcealer::prepare(double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    channels = juce::jlimit(1, static_cast<int>(AudioSharedData::maxChannels), numChannels);
+    
+    // O período mais longo ainda precisa de uma janela inteira de correlação atrás dele
+    minPeriod = juce::jmax(2, static_cast<int>(minPeriodSeconds * sampleRate));
+    maxPeriod = juce::jlimit(minPeriod, historyFrames - correlationFrames - 1,
+                             static_cast<int>(maxPeriodSeconds * sampleRate));
+    
+    decimation = juce::jmax(1, static_cast<int>(sampleRate / coarseSampleRate));
+    crossfadeFrames = juce::jmax(1, static_cast<int>(crossfadeSeconds * sampleRate));
+    tailDecayPerSample = static_cast<float>(std::pow(10.0, -3.0 / (tailDecaySeconds * sampleRate)));
+    
+    history.setSize(channels, historyFrames);
+    tail.setSize(channels, maxPeriod);
+    mixdown.assign(historyFrames, 0.0f);
+    decimated.assign(static_cast<size_t>(historyFrames / decimation), 0.0f);
+    
+    reset();
+}
+
+void UnderrunConcealer::reset()
+{
+    history.clear();
+    historyWritePosition = 0;
+    
+    concealing = false;
+    period = 0;
+    tailPosition = 0;
+    tailGain = 0.0f;
+}
+
+void UnderrunConcealer::pushHistory(const juce::AudioBuffer<float>& buffer, int startFrame, int numFrames)
+{
+    // Só os quadros mais recentes importam
+    if (numFrames > historyFrames)
+    {
+        startFrame += numFrames - historyFrames;
+        numFrames = historyFrames;
+    }
+    
+    const int firstPart = juce::jmin(numFrames, historyFrames - historyWritePosition);
+    const int numChannels = juce::jmin(channels, buffer.getNumChannels());
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* source = buffer.getReadPointer(channel, startFrame);
+        float* destination = history.getWritePointer(channel);
+        
+        juce::FloatVectorOperations::copy(destination + historyWritePosition, source, firstPart);
+        juce::FloatVectorOperations::copy(destination, source + firstPart, numFrames - firstPart);
+    }
+    
+    historyWritePosition = (historyWritePosition + numFrames) & (historyFrames - 1);
+}
+
+int UnderrunConcealer::findPeriod()
+{
+    // Histórico em mono e em ordem cronológica: mixdown[historyFrames - 1] é a última amostra
+    std::fill(mixdown.begin(), mixdown.end(), 0.0f);
+    
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        const float* source = history.getReadPointer(channel);
+        const int olderPart = historyFrames - historyWritePosition;
+        
+        juce::FloatVectorOperations::add(mixdown.data(), source + historyWritePosition, olderPart);
+        juce::FloatVectorOperations::add(mixdown.data() + olderPart, source, historyWritePosition);
+    }
+    
+    // Autocorrelação normalizada da janela mais recente contra a janela um período antes
+    const float* window = mixdown.data() + historyFrames - correlationFrames;
+    const double windowEnergy = dotProduct(window, window, correlationFrames);
+    
+    // Silêncio: qualquer período serve, a cauda também será silêncio
+    if (windowEnergy < 1.0e-9)
+        return minPeriod;
+    
+    // Busca grossa no histórico decimado por média (o passa-baixa basta para períodos de
+    // até 2 kHz), com a energia da janela atrasada atualizada incrementalmente a cada atraso
+    const int numDecimated = static_cast<int>(decimated.size());
+    const int skipped = historyFrames - numDecimated * decimation;
+    const float scale = 1.0f / static_cast<float>(decimation);
+    
+    for (int i = 0; i < numDecimated; ++i)
+    {
+        const float* group = mixdown.data() + skipped + i * decimation;
+        float sum = 0.0f;
+        
+        for (int k = 0; k < decimation; ++k)
+            sum += group[k];
+        
+        decimated[static_cast<size_t>(i)] = sum * scale;
+    }
+    
+    const int coarseWindow = juce::jmax(8, correlationFrames / decimation);
+    const int coarseStart = numDecimated - coarseWindow;
+    const int minCoarseLag = juce::jmax(1, minPeriod / decimation);
+    const int maxCoarseLag = juce::jmin(coarseStart, juce::jmax(minCoarseLag, maxPeriod / decimation));
+    const float* coarse = decimated.data() + coarseStart;
+    const double coarseEnergy = dotProduct(coarse, coarse, coarseWindow);
+    double laggedEnergy = dotProduct(coarse - minCoarseLag, coarse - minCoarseLag, coarseWindow);
+    int bestCoarseLag = minCoarseLag;
+    double bestScore = -2.0;
+    
+    for (int lag = minCoarseLag; lag <= maxCoarseLag; ++lag)
+    {
+        const float* lagged = coarse - lag;
+        const double score = dotProduct(coarse, lagged, coarseWindow)
+                           / std::sqrt(coarseEnergy * juce::jmax(0.0, laggedEnergy) + 1.0e-12);
+        
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestCoarseLag = lag;
+        }
+        
+        // A janela do próximo atraso ganha uma amostra no início e perde a última
+        if (lag < maxCoarseLag)
+            laggedEnergy += static_cast<double>(lagged[-1]) * lagged[-1]
+                          - static_cast<double>(lagged[coarseWindow - 1]) * lagged[coarseWindow - 1];
+    }
+    
+    // Refinamento na taxa original, só nos atrasos vizinhos ao melhor candidato
+    const int firstLag = juce::jmax(minPeriod, (bestCoarseLag - 1) * decimation);
+    const int lastLag = juce::jmin(maxPeriod, (bestCoarseLag + 1) * decimation);
+    int bestPeriod = juce::jlimit(minPeriod, maxPeriod, bestCoarseLag * decimation);
+    bestScore = -2.0;
+    
+    for (int lag = firstLag; lag <= lastLag; ++lag)
+    {
+        const float* lagged = window - lag;
+        const double score = dotProduct(window, lagged, correlationFrames)
+                           / std::sqrt(windowEnergy * dotProduct(lagged, lagged, correlationFrames) + 1.0e-12);
+        
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestPeriod = lag;
+        }
+    }
+    
+    return bestPeriod;
+}
+
+void UnderrunConcealer::beginConcealment()
+{
+    period = findPeriod();
+    tailPosition = 0;
+    tailGain = 1.0f;
+    
+    const int newest = (historyWritePosition - 1) & (historyFrames - 1);
+    
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        const float* source = history.getReadPointer(channel);
+        float* destination = tail.getWritePointer(channel);
+        
+        // A cauda repete o último período do histórico
+        for (int i = 0; i < period; ++i)
+            destination[i] = source[(newest - period + 1 + i) & (historyFrames - 1)];
+        
+        // A extrapolação prevê, para a última amostra real, o valor um período antes; a diferença
+        // é somada à cauda e some ao longo do crossfade, para não haver degrau na emenda
+        seamOffset[channel] = source[newest] - source[(newest - period) & (historyFrames - 1)];
+    }
+    
+    concealing = true;
+}
+
+void UnderrunConcealer::renderTail(juce::AudioBuffer<float>& buffer, int startFrame, int numFrames,
+                                   bool crossfadeIntoData)
+{
+    const int numChannels = juce::jmin(channels, buffer.getNumChannels());
+    int position = tailPosition;
+    float gain = tailGain;
+    
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* source = tail.getReadPointer(channel);
+        float* output = buffer.getWritePointer(channel, startFrame);
+        position = tailPosition;
+        gain = tailGain;
+        
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float sample = 0.0f;
+            
+            if (gain > 0.0f)
+            {
+                sample = source[position % period];
+                
+                if (position < crossfadeFrames)
+                    sample += seamOffset[channel] * (1.0f - static_cast<float>(position) / crossfadeFrames);
+                
+                sample *= gain;
+                
+                // Abaixo de -80 dB a cauda vira silêncio
+                gain *= tailDecayPerSample;
+                
+                if (gain < 1.0e-4f)
+                    gain = 0.0f;
+                
+                ++position;
+            }
+            
+            if (crossfadeIntoData)
+            {
+                // Dados de volta: entrada real sobe enquanto a cauda desce
+                const float fadeIn = static_cast<float>(i + 1) / (numFrames + 1);
+                output[i] = output[i] * fadeIn + sample * (1.0f - fadeIn);
+            }
+            else
+            {
+                output[i] = sample;
+            }
+        }
+    }
+    
+    // Canais de saída sem histórico ficam em silêncio
+    if (!crossfadeIntoData)
+        for (int channel = numChannels; channel < buffer.getNumChannels(); ++channel)
+            buffer.clear(channel, startFrame, numFrames);
+    
+    tailPosition = position;
+    tailGain = gain;
+}
+
+void UnderrunConcealer::process(juce::AudioBuffer<float>& buffer, int framesRead, int numSamples)
+{
+    if (channels == 0)
+        return;
+    
+    numSamples = juce::jmin(numSamples, buffer.getNumSamples());
+    framesRead = juce::jlimit(0, numSamples, framesRead);
+    
+    // Dados de volta depois de uma ocultação: misturar a cauda com o início dos dados
+    if (concealing && framesRead > 0)
+    {
+        renderTail(buffer, 0, juce::jmin(crossfadeFrames, framesRead), true);
+        concealing = false;
+    }
+    
+    pushHistory(buffer, 0, framesRead);
+    
+    if (framesRead == numSamples)
+        return;
+    
+    // Underrun: cada transição de dados reais para ocultação é um evento
+    if (!concealing)
+    {
+        beginConcealment();
+        concealmentCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    const int missingFrames = numSamples - framesRead;
+    renderTail(buffer, framesRead, missingFrames, false);
+    pushHistory(buffer, framesRead, missingFrames);
+    
+    concealedFrames.fetch_add(missingFrames, std::memory_order_relaxed);
+}
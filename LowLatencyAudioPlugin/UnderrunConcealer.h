@@ -0,0 +1,79 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include "SharedMemoryManager.h"
+#include <atomic>
+#include <vector>
+
+// Ocultação de underruns sem cliques
+//
+// Quando o ring não entrega o bloco inteiro, o restante do bloco é preenchido
+// com uma extrapolação periódica do áudio recente: o período é estimado por
+// autocorrelação sobre o histórico de saída (busca grossa numa versão decimada
+// do histórico e refinamento em torno do melhor candidato, para que o custo na
+// thread de áudio seja pequeno e limitado mesmo com muitas instâncias), a emenda com a última amostra real
+// é corrigida por um deslocamento que some em poucos milissegundos, e a cauda
+// decai até o silêncio. Quando os dados voltam, a entrada real é misturada com
+// a cauda (ou entra em fade-in, se a cauda já se apagou). Cada ocultação conta
+// um evento.
+class UnderrunConcealer
+{
+public:
+    UnderrunConcealer() = default;
+    
+    // Aloca o histórico (chamar fora da thread de áudio)
+    void prepare(double newSampleRate, int numChannels);
+    
+    // Esquece o histórico e a ocultação em curso, sem alocar
+    void reset();
+    
+    // Completa o buffer depois de uma leitura: os quadros [0, framesRead) são reais e
+    // [framesRead, numSamples) são preenchidos com a cauda de ocultação
+    void process(juce::AudioBuffer<float>& buffer, int framesRead, int numSamples);
+    
+    bool isConcealing() const { return concealing; }
+    
+    // Contadores (qualquer thread)
+    int getConcealmentCount() const { return concealmentCount.load(std::memory_order_relaxed); }
+    juce::int64 getConcealedFrames() const { return concealedFrames.load(std::memory_order_relaxed); }
+
+private:
+    void pushHistory(const juce::AudioBuffer<float>& buffer, int startFrame, int numFrames);
+    void beginConcealment();
+    int findPeriod();
+    void renderTail(juce::AudioBuffer<float>& buffer, int startFrame, int numFrames, bool crossfadeIntoData);
+    
+    static constexpr int historyFrames = 2048;              // histórico de saída por canal
+    static constexpr int correlationFrames = 256;           // janela da autocorrelação
+    static constexpr double minPeriodSeconds = 0.0005;      // 2 kHz
+    static constexpr double maxPeriodSeconds = 0.02;        // 50 Hz
+    static constexpr double coarseSampleRate = 11025.0;     // taxa aproximada da busca grossa
+    static constexpr double crossfadeSeconds = 0.0015;      // correção da emenda e retorno dos dados
+    static constexpr double tailDecaySeconds = 0.02;        // cauda cai 60 dB neste tempo
+    
+    double sampleRate = 44100.0;
+    int channels = 0;
+    int crossfadeFrames = 1;
+    float tailDecayPerSample = 0.0f;
+    
+    juce::AudioBuffer<float> history;   // circular, por canal
+    juce::AudioBuffer<float> tail;      // último período do histórico, linear
+    std::vector<float> mixdown;         // histórico em mono, linear, para a autocorrelação
+    std::vector<float> decimated;       // mixdown decimado, para a busca grossa
+    int historyWritePosition = 0;
+    int minPeriod = 1;
+    int maxPeriod = 1;
+    int decimation = 1;                 // quadros do histórico por amostra decimada
+    
+    // Estado da ocultação (somente a thread de áudio)
+    bool concealing = false;
+    int period = 0;
+    int tailPosition = 0;               // quadros gerados desde o início da ocultação
+    float tailGain = 0.0f;
+    float seamOffset[AudioSharedData::maxChannels] = {};
+    
+    std::atomic<int> concealmentCount { 0 };
+    std::atomic<juce::int64> concealedFrames { 0 };
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UnderrunConcealer)
+};
@@ -1,7 +1,27 @@
 #include "AudioFileReader.h"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
-AudioFileReader::AudioFileReader() 
+#if JUCE_LINUX || JUCE_MAC
+    #include <sys/mman.h>
+#endif
+
+namespace
+{
+    // Quadros de saída por passo de resampling: limita o buffer de origem contíguo
+    constexpr int resampleBlockFrames = 256;
+    constexpr double maxResampleRatio = 8.0;    // acima disso o passo fica menor
+    constexpr int interpolationMargin = 8;
+    
+    // Intervalo em que a thread de leitura volta a procurar buffers livres
+    constexpr int refillIntervalMs = 5;
+    
+    // Menor página das plataformas suportadas
+    constexpr int pageBytes = 4096;
+}
+
+AudioFileReader::AudioFileReader()
     : sampleRate(44100.0), targetSampleRate(44100.0), numChannels(0), length(0), position(0)
 {
     resampler = std::make_unique<juce::LagrangeInterpolator>();
@@ -26,27 +46,53 @@ bool AudioFileReader::openFile(const std::string& filePath)
     }
     
     juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats(); 
-     
-    juce::AudioFormatReader* reader = formatManager.createReaderFor(file);
-    if (reader == nullptr)
+    formatManager.registerBasicFormats();
+    
+    // WAV/AIFF em PCM são mapeados; os demais formatos são decodificados em trechos
+    if (!openMemoryMapped(file, formatManager))
+    {
+        juce::AudioFormatReader* reader = formatManager.createReaderFor(file);
+        if (reader == nullptr)
+        {
+            std::cerr << "'File format not supported': " << filePath << std::endl;
+            return false;
+        }
+        
+        formatReader.reset(reader);
+    }
+    
+    const juce::AudioFormatReader& details = mappedReader != nullptr ? *mappedReader : *formatReader;
+    sampleRate = details.sampleRate;
+    numChannels = static_cast<int>(details.numChannels);
+    length = details.lengthInSamples;
+    
+    if (length <= 0 || numChannels <= 0)
     {
-        std::cerr << "'File format not supported': " << filePath << std::endl;
+        std::cerr << "File has no audio: " << filePath << std::endl;
+        closeFile();
         return false;
     }
-
-    std::unique_ptr<juce::AudioFormatReader> formatReader(reader);
     
-    sampleRate = formatReader->sampleRate;
-    numChannels = formatReader->numChannels;
-    length = formatReader->lengthInSamples;
+    // Memória fixa, qualquer que seja a duração: os trechos (sem eles no modo mapeado) e o buffer de resampling
+    if (mappedReader == nullptr)
+    {
+        for (auto& chunk : chunks)
+            chunk.buffer.setSize(numChannels, chunkFrames);
+    }
     
-    audioData.setSize(numChannels, static_cast<int>(length));
-    formatReader->read(&audioData, 0, static_cast<int>(length), 0, true, true);
+    blockBuffer.setSize(numChannels, static_cast<int>(resampleBlockFrames * maxResampleRatio) + interpolationMargin);
     
     position = 0;
     
-    std::cout << "Open file: " << filePath << std::endl;
+    // O primeiro trecho é lido (ou preparado) aqui, para que o primeiro bloco não saia em silêncio
+    if (mappedReader != nullptr)
+        prepareMappedPages();
+    else
+        fillNextChunk();
+    
+    startReaderThread();
+    
+    std::cout << "Open file: " << filePath << (mappedReader != nullptr ? " (memory-mapped)" : " (streamed)") << std::endl;
     std::cout << "Sample rate: " << sampleRate << " Hz" << std::endl;
     std::cout << "Channels: " << numChannels << std::endl;
     std::cout << "Duration: " << length / sampleRate << " secs" << std::endl;
@@ -56,7 +102,32 @@ bool AudioFileReader::openFile(const std::string& filePath)
 
 void AudioFileReader::closeFile()
 {
-    audioData.clear();
+    stopReaderThread();
+    
+    if (readUnderruns.load() > 0)
+        std::cout << "Disk reader fell behind in " << readUnderruns.load() << " blocks" << std::endl;
+    
+    formatReader.reset();
+    mappedReader.reset();
+    adviceMap.reset();
+    dataOffset = 0;
+    bytesPerFrame = 0;
+    framesPlayed.store(0);
+    framesPrepared = 0;
+    
+    for (auto& chunk : chunks)
+    {
+        chunk.buffer.setSize(0, 0);
+        chunk.numFrames = 0;
+    }
+    
+    blockBuffer.setSize(0, 0);
+    chunksWritten.store(0);
+    chunksConsumed.store(0);
+    nextReadFrame = 0;
+    chunkOffset = 0;
+    resampleFraction = 0.0;
+    readUnderruns.store(0);
     numChannels = 0;
     length = 0;
     position = 0;
@@ -73,113 +144,329 @@ void AudioFileReader::setTargetSampleRate(double rate)
     std::cout << "Target sample rate set to: " << targetSampleRate << " Hz" << std::endl;
 }
 
-int AudioFileReader::getNextAudioBlock(float* outputBuffer, int numSamples)
+void AudioFileReader::startReaderThread()
 {
-    if (!isFileLoaded() || position >= length)
-        return 0;
+    stopReader.store(false);
     
-    // Verificar se precisamos fazer resampling
-    if (std::abs(sampleRate - targetSampleRate) > 0.01)
+    readerThread = std::thread([this]
     {
-        // Calcular a proporção de taxa de amostragem
-        double ratio = sampleRate / targetSampleRate;
-        
-        // Buffer temporário para amostras de origem (com um pouco de margem)
-        int sourceSamplesToRead = static_cast<int>(numSamples * ratio) + 8;
-        sourceSamplesToRead = juce::jmin(sourceSamplesToRead, static_cast<int>(length - position));
-        
-        if (sourceSamplesToRead <= 0)
-            return 0;
-        
-        // Criar buffer temporário para as amostras de origem
-        juce::HeapBlock<float> sourceBuffer(sourceSamplesToRead);
-        
-        // Preencher o buffer de origem com amostras do arquivo
-        if (numChannels > 1)
+        while (!stopReader.load(std::memory_order_acquire))
         {
-            // Mixdown para mono
-            for (int i = 0; i < sourceSamplesToRead; ++i)
-            {
-                float sample = 0.0f;
-                for (int ch = 0; ch < numChannels; ++ch)
-                {
-                    sample += audioData.getSample(ch, static_cast<int>(position) + i);
-                }
-                sourceBuffer[i] = sample / static_cast<float>(numChannels);
-            }
+            // Encher todos os buffers livres (ou preparar toda a janela à frente) e só então dormir
+            const bool didWork = mappedReader != nullptr ? prepareMappedPages() : fillNextChunk();
+            
+            if (!didWork)
+                std::this_thread::sleep_for(std::chrono::milliseconds(refillIntervalMs));
         }
-        else if (numChannels == 1)
+    });
+}
+
+void AudioFileReader::stopReaderThread()
+{
+    stopReader.store(true, std::memory_order_release);
+    
+    if (readerThread.joinable())
+        readerThread.join();
+}
+
+bool AudioFileReader::fillNextChunk()
+{
+    const uint64_t written = chunksWritten.load(std::memory_order_relaxed);
+    
+    // Todos os buffers ainda à espera da thread de render
+    if (written - chunksConsumed.load(std::memory_order_acquire) >= static_cast<uint64_t>(numChunks))
+        return false;
+    
+    // Trechos não atravessam o fim do arquivo: o último é parcial e o seguinte recomeça do início
+    auto& chunk = chunks[written % numChunks];
+    const int numFrames = static_cast<int>(juce::jmin<juce::int64>(chunkFrames, length - nextReadFrame));
+    
+    formatReader->read(&chunk.buffer, 0, numFrames, nextReadFrame, true, true);
+    chunk.numFrames = numFrames;
+    
+    nextReadFrame += numFrames;
+    
+    if (nextReadFrame >= length)
+        nextReadFrame = 0;
+    
+    chunksWritten.store(written + 1, std::memory_order_release);
+    return true;
+}
+
+bool AudioFileReader::openMemoryMapped(const juce::File& file, juce::AudioFormatManager& formatManager)
+{
+    auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+    
+    // Só WAV e AIFF têm leitor mapeado, e só para PCM sem compressão
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format != nullptr ? format->createMemoryMappedReader(file) : nullptr);
+    
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0 || !reader->mapEntireFile())
+        return false;
+    
+    mappedReader = std::move(reader);
+    bytesPerFrame = static_cast<int>(mappedReader->numChannels * mappedReader->bitsPerSample / 8);
+    
+    // As amostras costumam ser o último bloco do arquivo; se houver blocos depois delas, a
+    // janela aconselhada só fica deslocada de alguns KiB (o toque por página a cobre de qualquer jeito)
+    adviceMap = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    
+    if (adviceMap->getData() == nullptr)
+        adviceMap.reset();
+    else
+        dataOffset = juce::jmax<juce::int64>(0, static_cast<juce::int64>(adviceMap->getSize())
+                                                - mappedReader->lengthInSamples * bytesPerFrame);
+    
+    return true;
+}
+
+bool AudioFileReader::prepareMappedPages()
+{
+    const juce::int64 lookaheadFrames = static_cast<juce::int64>(chunkFrames) * numChunks;
+    const juce::int64 played = framesPlayed.load(std::memory_order_acquire);
+    
+    // A reprodução passou na frente: recomeçar do ponto atual
+    if (framesPrepared < played)
+        framesPrepared = played;
+    
+    if (framesPrepared - played >= lookaheadFrames)
+        return false;
+    
+    // Como os trechos decodificados, a janela não atravessa o fim do arquivo
+    const juce::int64 start = framesPrepared % length;
+    const juce::int64 numFrames = juce::jmin<juce::int64>(chunkFrames, length - start);
+   
+   #if JUCE_LINUX || JUCE_MAC
+    if (adviceMap != nullptr)
+    {
+        // Leitura antecipada assíncrona do trecho inteiro, em vez de uma falta de página por vez
+        const auto first = static_cast<size_t>(dataOffset + start * bytesPerFrame) & ~static_cast<size_t>(pageBytes - 1);
+        const auto last = juce::jmin(adviceMap->getSize(), static_cast<size_t>(dataOffset + (start + numFrames) * bytesPerFrame));
+        
+        if (last > first)
+            madvise(static_cast<char*>(adviceMap->getData()) + first, last - first, MADV_WILLNEED);
+    }
+   #endif
+   
+    // Tocar uma amostra por página também a coloca no mapeamento do leitor: a thread de
+    // render não toma nem a falta de página menor
+    const juce::int64 framesPerPage = juce::jmax(1, pageBytes / juce::jmax(1, bytesPerFrame));
+    
+    for (juce::int64 frame = start; frame < start + numFrames; frame += framesPerPage)
+        mappedReader->touchSample(frame);
+    
+    framesPrepared += numFrames;
+    return true;
+}
+
+int AudioFileReader::sourceChannelFor(int outputChannel) const
+{
+    // Canal do arquivo usado por uma saída (-1 quando a saída não tem correspondente)
+    if (numChannels == 1)
+        return 0;
+    
+    return outputChannel < numChannels ? outputChannel : -1;
+}
+
+int AudioFileReader::peekFrames(float* const* destinations, int numDestinations, int numFrames)
+{
+    if (mappedReader != nullptr)
+    {
+        // Conversão direto das páginas mapeadas para float (vetorizada pelo JUCE), sem cópia intermediária
+        const int numRead = juce::jmin(numDestinations, numChannels);
+        mappedReader->read(destinations, numRead, position, numFrames);
+        
+        for (int channel = numRead; channel < numDestinations; ++channel)
         {
-            // Copiar diretamente do canal mono
-            for (int i = 0; i < sourceSamplesToRead; ++i)
-            {
-                sourceBuffer[i] = audioData.getSample(0, static_cast<int>(position) + i);
-            }
+            if (numChannels == 1)
+                juce::FloatVectorOperations::copy(destinations[channel], destinations[0], numFrames);
+            else
+                juce::FloatVectorOperations::clear(destinations[channel], numFrames);
         }
         
-        // Usar interpolação linear básica em vez do LagrangeInterpolator
-        // Esta abordagem é mais simples e evita os problemas com a API do JUCE
-        for (int i = 0; i < numSamples; ++i)
+        return numFrames;
+    }
+    
+    const uint64_t written = chunksWritten.load(std::memory_order_acquire);
+    uint64_t index = chunksConsumed.load(std::memory_order_relaxed);
+    int offset = chunkOffset;
+    int copied = 0;
+    
+    while (copied < numFrames && index < written)
+    {
+        const auto& chunk = chunks[index % numChunks];
+        const int count = juce::jmin(numFrames - copied, chunk.numFrames - offset);
+        
+        for (int channel = 0; channel < numDestinations; ++channel)
         {
-            double sourcePos = i * ratio;
-            int sourcePos1 = static_cast<int>(sourcePos);
-            int sourcePos2 = sourcePos1 + 1;
+            const int sourceChannel = sourceChannelFor(channel);
             
-            if (sourcePos2 >= sourceSamplesToRead)
-                break;  // Evitar acesso fora dos limites
-                
-            float fraction = static_cast<float>(sourcePos - sourcePos1);
-            outputBuffer[i] = sourceBuffer[sourcePos1] + fraction * (sourceBuffer[sourcePos2] - sourceBuffer[sourcePos1]);
+            if (sourceChannel < 0)
+                juce::FloatVectorOperations::clear(destinations[channel] + copied, count);
+            else
+                juce::FloatVectorOperations::copy(destinations[channel] + copied,
+                                                  chunk.buffer.getReadPointer(sourceChannel, offset), count);
         }
         
-        // Atualizar a posição considerando a taxa de amostragem
-        position += static_cast<juce::int64>(numSamples * ratio);
+        copied += count;
+        offset = 0;
+        ++index;
+    }
+    
+    return copied;
+}
+
+void AudioFileReader::advance(juce::int64 numFrames)
+{
+    // No fim do arquivo, não avançar para dentro do trecho que recomeça do início
+    numFrames = juce::jmin(numFrames, length - position);
+    position += numFrames;
+    framesPlayed.store(framesPlayed.load(std::memory_order_relaxed) + numFrames, std::memory_order_release);
+    
+    if (mappedReader == nullptr)
+    {
+        chunkOffset += static_cast<int>(numFrames);
+        
+        // Devolver à thread de leitura os trechos já tocados por inteiro
+        uint64_t consumed = chunksConsumed.load(std::memory_order_relaxed);
+        const uint64_t written = chunksWritten.load(std::memory_order_acquire);
         
-        // Verificar se chegamos ao final do arquivo
-        if (position >= length)
+        while (consumed < written && chunkOffset >= chunks[consumed % numChunks].numFrames)
         {
-            position = 0;
-            std::cout << "End of file reached, resetting position to start." << std::endl;
+            chunkOffset -= chunks[consumed % numChunks].numFrames;
+            ++consumed;
         }
         
-        return numSamples;
+        chunksConsumed.store(consumed, std::memory_order_release);
     }
-    else
+    
+    // Verificar se chegamos ao final do arquivo
+    if (position >= length)
     {
-        // Se não precisa de resampling, usar o código original
-        int samplesAvailable = static_cast<int>(length - position);
-        int samplesToRead = juce::jmin(numSamples, samplesAvailable);
+        position = 0;
+        resampleFraction = 0.0;
+        std::cout << "End of file reached, resetting position to start." << std::endl;
+    }
+}
+
+int AudioFileReader::getNextAudioBlock(float* const* outputChannels, int numOutputChannels, int numSamples)
+{
+    if (!isFileLoaded() || position >= length)
+        return 0;
+    
+    // Verificar se precisamos fazer resampling
+    if (std::abs(sampleRate - targetSampleRate) > 0.01)
+    {
+        // Calcular a proporção de taxa de amostragem
+        const double ratio = sampleRate / targetSampleRate;
+        
+        // Passos de até resampleBlockFrames quadros, para que a origem caiba em blockBuffer
+        const int maxSourceFrames = blockBuffer.getNumSamples();
+        const int stepFrames = juce::jmax(1, juce::jmin(resampleBlockFrames,
+                                                        static_cast<int>((maxSourceFrames - interpolationMargin) / ratio)));
+        int produced = 0;
         
-        // Código original para o caso sem resampling...
-        if (numChannels > 1)
+        while (produced < numSamples)
         {
-            for (int i = 0; i < samplesToRead; ++i)
+            int frames = juce::jmin(stepFrames, numSamples - produced);
+            
+            // Perto do fim do arquivo, só os quadros cuja interpolação ainda cabe no que resta;
+            // o passo seguinte continua do início do arquivo
+            const juce::int64 remaining = length - position;
+            const double framesBeforeEnd = (static_cast<double>(remaining - 1) - resampleFraction) / ratio;
+            const int framesToEnd = framesBeforeEnd > 0.0 ? static_cast<int>(std::ceil(framesBeforeEnd)) : 0;
+            const bool reachesEnd = framesToEnd <= frames;
+            
+            if (reachesEnd)
             {
-                float sample = 0.0f;
-                for (int ch = 0; ch < numChannels; ++ch)
-                {
-                    sample += audioData.getSample(ch, static_cast<int>(position) + i);
-                }
-                outputBuffer[i] = sample / static_cast<float>(numChannels);
+                // Arquivo curto demais para interpolar: nada a produzir
+                if (framesToEnd == 0 && position == 0)
+                    break;
+                
+                frames = framesToEnd;
             }
-        }
-        else if (numChannels == 1)
-        {
-            for (int i = 0; i < samplesToRead; ++i)
+            
+            // Quantidade de amostras de origem disponíveis para este passo (com um pouco de margem)
+            int sourceSamplesToRead = static_cast<int>(resampleFraction + frames * ratio) + interpolationMargin;
+            sourceSamplesToRead = juce::jmin(sourceSamplesToRead, maxSourceFrames, static_cast<int>(remaining));
+            
+            // A leitura ainda não chegou aqui: entregar o que já foi produzido
+            if (frames > 0 && peekFrames(blockBuffer.getArrayOfWritePointers(), numChannels, sourceSamplesToRead) < sourceSamplesToRead)
+            {
+                readUnderruns.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            
+            // Interpolação linear a partir dos quadros contíguos do passo
+            for (int channel = 0; channel < numOutputChannels; ++channel)
             {
-                outputBuffer[i] = audioData.getSample(0, static_cast<int>(position) + i);
+                float* output = outputChannels[channel] + produced;
+                const int sourceChannel = sourceChannelFor(channel);
+                
+                if (sourceChannel < 0)
+                {
+                    juce::FloatVectorOperations::clear(output, frames);
+                    continue;
+                }
+                
+                const float* source = blockBuffer.getReadPointer(sourceChannel);
+                
+                for (int i = 0; i < frames; ++i)
+                {
+                    double sourcePos = resampleFraction + i * ratio;
+                    int sourcePos1 = static_cast<int>(sourcePos);
+                    int sourcePos2 = sourcePos1 + 1;
+                    
+                    if (sourcePos2 >= sourceSamplesToRead)
+                    {
+                        // Evitar acesso fora dos limites
+                        juce::FloatVectorOperations::clear(output + i, frames - i);
+                        break;
+                    }
+                    
+                    float fraction = static_cast<float>(sourcePos - sourcePos1);
+                    output[i] = source[sourcePos1] + fraction * (source[sourcePos2] - source[sourcePos1]);
+                }
             }
+            
+            // Atualizar a posição considerando a taxa de amostragem (a fração segue para o próximo passo).
+            // No fim do arquivo, o resto que não cabe em mais nenhum quadro é pulado e advance volta ao início
+            const double sourceAdvance = resampleFraction + frames * ratio;
+            const juce::int64 wholeFrames = static_cast<juce::int64>(sourceAdvance);
+            resampleFraction = sourceAdvance - static_cast<double>(wholeFrames);
+            produced += frames;
+            
+            advance(reachesEnd ? remaining : wholeFrames);
         }
         
-        position += samplesToRead;
+        return produced;
+    }
+    else
+    {
+        // Se não precisa de resampling, copiar direto dos trechos decodificados. No fim do
+        // arquivo, advance volta ao início e o bloco continua de lá, sem lacuna
+        const int numDestinations = juce::jmin(numOutputChannels, maxOutputChannels);
+        float* destinations[maxOutputChannels] = {};
+        int produced = 0;
         
-        if (position >= length)
+        while (produced < numSamples)
         {
-            position = 0;
-            std::cout << "End of file reached, resetting position to start." << std::endl;
+            for (int channel = 0; channel < numDestinations; ++channel)
+                destinations[channel] = outputChannels[channel] + produced;
+            
+            const int samplesAvailable = static_cast<int>(juce::jmin<juce::int64>(numSamples - produced, length - position));
+            const int samplesToRead = peekFrames(destinations, numDestinations, samplesAvailable);
+            
+            advance(samplesToRead);
+            produced += samplesToRead;
+            
+            if (samplesToRead < samplesAvailable)
+            {
+                readUnderruns.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
         }
         
-        return samplesToRead;
+        return produced;
     }
 }
 
@@ -190,5 +477,27 @@ double AudioFileReader::getSampleRate() const
 
 void AudioFileReader::resetPosition()
 {
+    if (!isFileLoaded())
+    {
+        position = 0;
+        return;
+    }
+    
+    // Descartar o que já foi decodificado e recomeçar a leitura do início
+    stopReaderThread();
+    chunksWritten.store(0);
+    chunksConsumed.store(0);
+    nextReadFrame = 0;
+    chunkOffset = 0;
+    resampleFraction = 0.0;
     position = 0;
+    framesPlayed.store(0);
+    framesPrepared = 0;
+    
+    if (mappedReader != nullptr)
+        prepareMappedPages();
+    else
+        fillNextChunk();
+    
+    startReaderThread();
 }
\ No newline at end of file
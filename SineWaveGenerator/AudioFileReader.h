@@ -1,9 +1,24 @@
 #pragma once
 
 #include "JuceHeader.h"
+#include <atomic>
 #include <string>
+#include <thread>
 
 // Classe para gerenciar a leitura de arquivos de áudio
+//
+// O arquivo não é carregado inteiro na memória: uma thread de leitura decodifica
+// trechos de chunkFrames quadros à frente da posição de reprodução, em numChunks
+// buffers alocados ao abrir. A entrega para a thread de render é uma fila SPSC sem
+// lock (contadores atômicos de trechos escritos e consumidos), então abrir é quase
+// instantâneo e a memória usada não depende da duração do arquivo. Se a leitura
+// ficar para trás, o bloco sai mais curto (só o que já foi lido) e a falta é contada.
+//
+// WAV e AIFF em PCM não passam pelos trechos: o arquivo é mapeado na memória
+// (MemoryMappedAudioFormatReader) e a thread de render converte as amostras direto
+// das páginas mapeadas. A thread de leitura passa a só preparar as páginas à frente
+// da reprodução (madvise(MADV_WILLNEED) e um toque por página), e vários geradores
+// tocando o mesmo arquivo dividem uma única cópia no cache de páginas.
 class AudioFileReader
 {
 public:
@@ -14,14 +29,79 @@ public:
     void closeFile();
     bool isFileLoaded() const;
     
-    int getNextAudioBlock(float* outputBuffer, int numSamples);
+    // Preenche numOutputChannels canais planares sem mixdown: o canal N do arquivo vai
+    // para a saída N, um arquivo mono é replicado em todas as saídas e saídas sem
+    // canal correspondente no arquivo recebem silêncio. O arquivo toca em loop sem
+    // lacuna; retorna menos que numSamples só se a leitura ainda não chegou ao trecho
+    int getNextAudioBlock(float* const* outputChannels, int numOutputChannels, int numSamples);
+    
+    int getNumChannels() const { return numChannels; }
     
     double getSampleRate() const;
     void setTargetSampleRate(double rate);
+    
+    // Volta ao início do arquivo; como openFile, não chamar durante o render
     void resetPosition();
     
+    // Blocos em que a thread de leitura ainda não tinha os dados
+    int getReadUnderruns() const { return readUnderruns.load(std::memory_order_relaxed); }
+    
+    // Arquivo mapeado na memória em vez de decodificado em trechos
+    bool isMemoryMapped() const { return mappedReader != nullptr; }
+    
+    static constexpr int chunkFrames = 8192;
+    static constexpr int numChunks = 16;        // ~2.7 s à frente a 48 kHz
+    static constexpr int maxOutputChannels = 16;    // como AudioSharedData::maxChannels
+
 private:
-    juce::AudioSampleBuffer audioData;
+    // Trecho decodificado; pertence à thread de leitura até ser publicado em chunksWritten
+    // e à thread de render até ser liberado em chunksConsumed
+    struct Chunk {
+        juce::AudioSampleBuffer buffer;
+        int numFrames = 0;
+    };
+    
+    void startReaderThread();
+    void stopReaderThread();
+    
+    // Tenta o caminho mapeado (WAV/AIFF em PCM); false para usar os trechos decodificados
+    bool openMemoryMapped(const juce::File& file, juce::AudioFormatManager& formatManager);
+    
+    // Thread de leitura: decodifica o próximo trecho se houver buffer livre
+    bool fillNextChunk();
+    
+    // Thread de leitura, modo mapeado: prepara as páginas do próximo trecho à frente da reprodução
+    bool prepareMappedPages();
+    
+    // Thread de render: copia até numFrames quadros a partir da posição atual, sem
+    // consumi-los, e retorna quantos já estavam disponíveis
+    int peekFrames(float* const* destinations, int numDestinations, int numFrames);
+    void advance(juce::int64 numFrames);
+    int sourceChannelFor(int outputChannel) const;
+    
+    std::unique_ptr<juce::AudioFormatReader> formatReader;  // usado só pela thread de leitura depois de aberto
+    Chunk chunks[numChunks];
+    std::atomic<uint64_t> chunksWritten { 0 };
+    std::atomic<uint64_t> chunksConsumed { 0 };
+    juce::int64 nextReadFrame = 0;      // próximo quadro a decodificar (thread de leitura)
+    std::thread readerThread;
+    std::atomic<bool> stopReader { false };
+    
+    // Modo mapeado. O leitor do JUCE não expõe o endereço do seu mapeamento: os conselhos
+    // ao kernel vão para um segundo mapeamento do mesmo arquivo (só espaço de endereços;
+    // as páginas do cache são as mesmas)
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader;
+    std::unique_ptr<juce::MemoryMappedFile> adviceMap;
+    juce::int64 dataOffset = 0;             // início estimado das amostras no arquivo
+    int bytesPerFrame = 0;
+    std::atomic<juce::int64> framesPlayed { 0 };    // quadros consumidos desde a abertura (render)
+    juce::int64 framesPrepared = 0;                 // quadros com páginas já preparadas (thread de leitura)
+    
+    juce::AudioSampleBuffer blockBuffer;    // quadros de origem contíguos para o resampling
+    int chunkOffset = 0;                    // quadros já consumidos do trecho da frente
+    double resampleFraction = 0.0;          // parte fracionária da posição de origem
+    std::atomic<int> readUnderruns { 0 };
+    
     double sampleRate;
     double targetSampleRate;  // plugin sample rate
     int numChannels;
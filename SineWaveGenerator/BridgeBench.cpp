@@ -0,0 +1,532 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "JuceHeader.h"
+#include "SharedMemoryManager.h"
+
+// Transport microbenchmark for the shared ring: writeAudioData on one side, readAudioData on
+// the other, for every combination of block size and channel count. Each case runs in a
+// segment of its own (never the one the plugin uses), in up to three topologies:
+//
+//   inline     one thread writes a block and reads it back (copy cost, no cross-core traffic)
+//   threads    producer and consumer threads in this process
+//   processes  the producer is a second copy of this program, as with the real generator
+//
+// Every case runs twice. The streaming pass keeps the ring full and gives the throughput
+// (ns per frame and GB/s of sample data moved). The lockstep pass only writes the next block
+// once the consumer has drained the ring, so the age of each block when its read returns
+// (block stamp to end of read, on the shared monotonic clock) is the transport latency
+// rather than queueing delay; its percentiles are reported in microseconds.
+
+enum class Topology { Inline, Threads, Processes };
+enum class Pattern { Streaming, Lockstep };
+
+// Command-line options
+struct BenchOptions {
+    std::vector<int> blockSizes { 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384 };
+    std::vector<int> channelCounts { 1, 2, 8 };
+    std::vector<Topology> topologies { Topology::Inline, Topology::Threads, Topology::Processes };
+    int capacityFrames = 0;     // Ring size; 0 = four blocks, at least the default ring
+    double seconds = 0.5;       // Duration of each pass
+    bool json = false;          // One JSON object per case instead of the table
+};
+
+struct BenchCase {
+    int blockSize = 0;
+    int numChannels = 0;
+    int capacityFrames = 0;
+    std::string segmentName;
+};
+
+// What the consumer saw during one pass
+struct PassResult {
+    bool ok = false;
+    uint64_t frames = 0;
+    uint64_t elapsedNs = 0;             // First to last successful read
+    std::vector<uint64_t> latenciesNs;  // Block age at the end of each read
+};
+
+struct BenchResult {
+    Topology topology = Topology::Inline;
+    BenchCase benchCase;
+    double nsPerFrame = 0.0;
+    double gigabytesPerSecond = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    double maxUs = 0.0;
+};
+
+static const char* getTopologyName(Topology topology)
+{
+    switch (topology)
+    {
+        case Topology::Inline:      return "inline";
+        case Topology::Threads:     return "threads";
+        case Topology::Processes:   return "processes";
+    }
+    
+    return "?";
+}
+
+// Busy-wait step; yields now and then so a producer and a consumer sharing one core still progress
+static void spinPause(int& spins)
+{
+    if (++spins % 256 == 0)
+        std::this_thread::yield();
+}
+
+static SharedMemoryManager::Config makeConfig(const BenchCase& benchCase)
+{
+    SharedMemoryManager::Config config;
+    config.capacityFrames = benchCase.capacityFrames;
+    config.numChannels = benchCase.numChannels;
+    config.maxStreams = 1;
+    config.segmentName = benchCase.segmentName;
+    return config;
+}
+
+// Source planes filled with noise, so the copies move real data
+struct SourceBlock {
+    SourceBlock(int numChannels, int blockSize) : planes(static_cast<size_t>(numChannels))
+    {
+        juce::Random random;
+        
+        for (auto& plane : planes)
+        {
+            plane.resize(static_cast<size_t>(blockSize));
+            
+            for (auto& sample : plane)
+                sample = random.nextFloat() * 2.0f - 1.0f;
+            
+            pointers.push_back(plane.data());
+        }
+    }
+    
+    std::vector<std::vector<float>> planes;
+    std::vector<const float*> pointers;
+};
+
+// Producer side of a threads or processes pass: waits for the consumer, then writes whole
+// blocks until the time is up and marks the generator inactive so the consumer can stop
+static bool runProducer(SharedMemoryManager& sharedMemory, const BenchCase& benchCase, Pattern pattern, double seconds)
+{
+    SourceBlock source(benchCase.numChannels, benchCase.blockSize);
+    const int capacity = sharedMemory.getCapacity();
+    const int requiredSpace = pattern == Pattern::Lockstep ? capacity : benchCase.blockSize;
+    int spins = 0;
+    
+    const uint64_t attachDeadline = SharedMemoryManager::getMonotonicNanoseconds() + 5000000000ull;
+    
+    while (!sharedMemory.getStreamInfo(0).consumerAttached)
+    {
+        if (SharedMemoryManager::getMonotonicNanoseconds() > attachDeadline)
+            return false;
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    sharedMemory.setGeneratorActive(true);
+    
+    const uint64_t endNs = SharedMemoryManager::getMonotonicNanoseconds() + static_cast<uint64_t>(seconds * 1.0e9);
+    
+    while (SharedMemoryManager::getMonotonicNanoseconds() < endNs)
+    {
+        if (sharedMemory.getFreeSpace() < requiredSpace)
+        {
+            spinPause(spins);
+            continue;
+        }
+        
+        sharedMemory.writeAudioData(source.pointers.data(), benchCase.numChannels, benchCase.blockSize);
+    }
+    
+    sharedMemory.setGeneratorActive(false);
+    return true;
+}
+
+// Consumer side: reads blocks until the producer is done and the ring is empty
+static PassResult runConsumer(SharedMemoryManager& sharedMemory, const BenchCase& benchCase, double seconds)
+{
+    PassResult result;
+    juce::AudioBuffer<float> buffer(benchCase.numChannels, benchCase.blockSize);
+    SharedMemoryManager::ReadTiming timing;
+    uint64_t firstReadNs = 0;
+    uint64_t lastReadNs = 0;
+    bool producerStarted = false;
+    int spins = 0;
+    
+    // Enough room for a lockstep pass at a few microseconds per block, so the pass does not reallocate
+    result.latenciesNs.reserve(static_cast<size_t>(juce::jlimit(1024.0, 4.0e6, seconds * 400000.0)));
+    
+    const uint64_t giveUpNs = SharedMemoryManager::getMonotonicNanoseconds() + static_cast<uint64_t>((seconds + 10.0) * 1.0e9);
+    
+    for (;;)
+    {
+        const int framesRead = sharedMemory.readAudioData(buffer, benchCase.blockSize, timing);
+        const uint64_t now = SharedMemoryManager::getMonotonicNanoseconds();
+        
+        if (framesRead > 0)
+        {
+            if (firstReadNs == 0)
+                firstReadNs = now;
+            
+            lastReadNs = now;
+            result.frames += static_cast<uint64_t>(framesRead);
+            
+            if (timing.numStamps > 0 && now > timing.stamps[0].timestampNs)
+                result.latenciesNs.push_back(now - timing.stamps[0].timestampNs);
+            
+            continue;
+        }
+        
+        const bool active = sharedMemory.isGeneratorActive();
+        producerStarted = producerStarted || active;
+        
+        if (producerStarted && !active && sharedMemory.getNumSamplesAvailable() == 0)
+            break;
+        
+        if (now > giveUpNs)
+            return result;
+        
+        spinPause(spins);
+    }
+    
+    result.elapsedNs = lastReadNs - firstReadNs;
+    result.ok = result.frames > 0;
+    return result;
+}
+
+// One thread alternates between writing a block and reading it back
+static PassResult runInlinePass(const BenchCase& benchCase, double seconds)
+{
+    PassResult result;
+    SharedMemoryManager producer;
+    SharedMemoryManager consumer;
+    
+    if (!producer.initialize(makeConfig(benchCase)) || !consumer.initialize(makeConfig(benchCase))
+        || !producer.registerStream(0, "BridgeBench", benchCase.numChannels) || !consumer.attachStream(0))
+        return result;
+    
+    SourceBlock source(benchCase.numChannels, benchCase.blockSize);
+    juce::AudioBuffer<float> buffer(benchCase.numChannels, benchCase.blockSize);
+    SharedMemoryManager::ReadTiming timing;
+    
+    result.latenciesNs.reserve(static_cast<size_t>(juce::jlimit(1024.0, 4.0e6, seconds * 400000.0)));
+    
+    const uint64_t startNs = SharedMemoryManager::getMonotonicNanoseconds();
+    const uint64_t endNs = startNs + static_cast<uint64_t>(seconds * 1.0e9);
+    uint64_t now = startNs;
+    
+    while (now < endNs)
+    {
+        producer.writeAudioData(source.pointers.data(), benchCase.numChannels, benchCase.blockSize);
+        const int framesRead = consumer.readAudioData(buffer, benchCase.blockSize, timing);
+        now = SharedMemoryManager::getMonotonicNanoseconds();
+        
+        result.frames += static_cast<uint64_t>(framesRead);
+        
+        if (timing.numStamps > 0 && now > timing.stamps[0].timestampNs)
+            result.latenciesNs.push_back(now - timing.stamps[0].timestampNs);
+    }
+    
+    result.elapsedNs = now - startNs;
+    result.ok = result.frames > 0;
+    return result;
+}
+
+static PassResult runThreadsPass(const BenchCase& benchCase, Pattern pattern, double seconds)
+{
+    SharedMemoryManager producer;
+    SharedMemoryManager consumer;
+    
+    if (!producer.initialize(makeConfig(benchCase)) || !consumer.initialize(makeConfig(benchCase))
+        || !producer.registerStream(0, "BridgeBench", benchCase.numChannels) || !consumer.attachStream(0))
+        return {};
+    
+    std::thread producerThread([&] { runProducer(producer, benchCase, pattern, seconds); });
+    auto result = runConsumer(consumer, benchCase, seconds);
+    producerThread.join();
+    return result;
+}
+
+// The producer runs in a child process started from this executable with --producer
+static PassResult runProcessesPass(const BenchCase& benchCase, Pattern pattern, double seconds)
+{
+    SharedMemoryManager consumer;
+    
+    if (!consumer.initialize(makeConfig(benchCase)))
+        return {};
+    
+    juce::StringArray arguments;
+    arguments.add(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getFullPathName());
+    arguments.add("--producer");
+    arguments.add(benchCase.segmentName);
+    arguments.add(juce::String(benchCase.blockSize));
+    arguments.add(juce::String(benchCase.numChannels));
+    arguments.add(juce::String(benchCase.capacityFrames));
+    arguments.add(pattern == Pattern::Lockstep ? "lockstep" : "streaming");
+    arguments.add(juce::String(seconds, 3));
+    
+    juce::ChildProcess child;
+    
+    if (!child.start(arguments, 0))
+        return {};
+    
+    // The child registers the stream once it has opened the segment
+    const uint64_t registerDeadline = SharedMemoryManager::getMonotonicNanoseconds() + 5000000000ull;
+    
+    while (!consumer.getStreamInfo(0).active || !consumer.attachStream(0))
+    {
+        if (SharedMemoryManager::getMonotonicNanoseconds() > registerDeadline || !child.isRunning())
+        {
+            child.kill();
+            return {};
+        }
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    auto result = runConsumer(consumer, benchCase, seconds);
+    
+    if (!child.waitForProcessToFinish(10000))
+        child.kill();
+    
+    result.ok = result.ok && child.getExitCode() == 0;
+    return result;
+}
+
+static int runProducerProcess(int argc, char* argv[])
+{
+    if (argc < 8)
+        return 1;
+    
+    BenchCase benchCase;
+    benchCase.segmentName = argv[2];
+    benchCase.blockSize = std::atoi(argv[3]);
+    benchCase.numChannels = std::atoi(argv[4]);
+    benchCase.capacityFrames = std::atoi(argv[5]);
+    const Pattern pattern = std::string(argv[6]) == "lockstep" ? Pattern::Lockstep : Pattern::Streaming;
+    const double seconds = std::atof(argv[7]);
+    
+    SharedMemoryManager producer;
+    
+    if (!producer.initialize(makeConfig(benchCase)) || !producer.registerStream(0, "BridgeBench", benchCase.numChannels))
+        return 1;
+    
+    return runProducer(producer, benchCase, pattern, seconds) ? 0 : 1;
+}
+
+static double percentileUs(std::vector<uint64_t>& values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    
+    const size_t index = juce::jmin(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return static_cast<double>(values[index]) / 1000.0;
+}
+
+static bool runCase(Topology topology, const BenchCase& benchCase, double seconds, BenchResult& result)
+{
+    PassResult streaming;
+    PassResult lockstep;
+    
+    switch (topology)
+    {
+        case Topology::Inline:
+            // Write and read alternate, so both figures come from the same pass
+            streaming = runInlinePass(benchCase, seconds);
+            lockstep = streaming;
+            break;
+        
+        case Topology::Threads:
+            streaming = runThreadsPass(benchCase, Pattern::Streaming, seconds);
+            lockstep = runThreadsPass(benchCase, Pattern::Lockstep, seconds);
+            break;
+        
+        case Topology::Processes:
+            streaming = runProcessesPass(benchCase, Pattern::Streaming, seconds);
+            lockstep = runProcessesPass(benchCase, Pattern::Lockstep, seconds);
+            break;
+    }
+    
+    if (!streaming.ok || !lockstep.ok || streaming.elapsedNs == 0)
+        return false;
+    
+    const double bytes = static_cast<double>(streaming.frames) * benchCase.numChannels * sizeof(float);
+    
+    result.topology = topology;
+    result.benchCase = benchCase;
+    result.nsPerFrame = static_cast<double>(streaming.elapsedNs) / static_cast<double>(streaming.frames);
+    result.gigabytesPerSecond = bytes / static_cast<double>(streaming.elapsedNs);
+    result.p50Us = percentileUs(lockstep.latenciesNs, 0.5);
+    result.p99Us = percentileUs(lockstep.latenciesNs, 0.99);
+    result.p999Us = percentileUs(lockstep.latenciesNs, 0.999);
+    result.maxUs = lockstep.latenciesNs.empty() ? 0.0
+                 : static_cast<double>(*std::max_element(lockstep.latenciesNs.begin(), lockstep.latenciesNs.end())) / 1000.0;
+    return true;
+}
+
+static void printHeader()
+{
+    std::cout << std::left << std::setw(10) << "mode" << std::right
+              << std::setw(7) << "frames" << std::setw(4) << "ch" << std::setw(7) << "ring"
+              << std::setw(10) << "ns/frame" << std::setw(8) << "GB/s"
+              << std::setw(9) << "p50 us" << std::setw(9) << "p99 us" << std::setw(10) << "p99.9 us" << std::setw(10) << "max us"
+              << std::endl;
+}
+
+static void printRow(const BenchResult& result)
+{
+    std::cout << std::left << std::setw(10) << getTopologyName(result.topology) << std::right
+              << std::setw(7) << result.benchCase.blockSize << std::setw(4) << result.benchCase.numChannels
+              << std::setw(7) << result.benchCase.capacityFrames
+              << std::fixed << std::setprecision(3) << std::setw(10) << result.nsPerFrame
+              << std::setprecision(2) << std::setw(8) << result.gigabytesPerSecond
+              << std::setprecision(1) << std::setw(9) << result.p50Us << std::setw(9) << result.p99Us
+              << std::setw(10) << result.p999Us << std::setw(10) << result.maxUs
+              << std::defaultfloat << std::endl;
+}
+
+static void printJson(const BenchResult& result)
+{
+    std::cout << "{\"mode\":\"" << getTopologyName(result.topology) << "\""
+              << ",\"blockSize\":" << result.benchCase.blockSize
+              << ",\"channels\":" << result.benchCase.numChannels
+              << ",\"capacityFrames\":" << result.benchCase.capacityFrames
+              << ",\"nsPerFrame\":" << result.nsPerFrame
+              << ",\"gigabytesPerSecond\":" << result.gigabytesPerSecond
+              << ",\"latencyUs\":{\"p50\":" << result.p50Us << ",\"p99\":" << result.p99Us
+              << ",\"p999\":" << result.p999Us << ",\"max\":" << result.maxUs << "}}" << std::endl;
+}
+
+static std::vector<int> parseList(const std::string& text)
+{
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    
+    while (std::getline(stream, item, ','))
+        if (std::atoi(item.c_str()) > 0)
+            values.push_back(std::atoi(item.c_str()));
+    
+    return values;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: BridgeBench [options]\n"
+              << "  --blocks <n,n,...>    Block sizes in frames (default 32 to 16384, powers of two)\n"
+              << "  --channels <n,n,...>  Channel counts (default 1,2,8)\n"
+              << "  --mode <name>         inline, threads, processes or all (default all)\n"
+              << "  --capacity <frames>   Ring size (default: four blocks, at least "
+              << AudioSharedData::defaultCapacityFrames << ")\n"
+              << "  --seconds <s>         Duration of each pass (default 0.5)\n"
+              << "  --json                One JSON object per case instead of the table\n"
+              << "Samples are 32-bit float, the only format the shared ring carries." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--producer")
+        return runProducerProcess(argc, argv);
+    
+    BenchOptions options;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        
+        if (arg == "--blocks" && i + 1 < argc)
+        {
+            options.blockSizes = parseList(argv[++i]);
+        }
+        else if (arg == "--channels" && i + 1 < argc)
+        {
+            options.channelCounts = parseList(argv[++i]);
+        }
+        else if (arg == "--mode" && i + 1 < argc)
+        {
+            const std::string mode = argv[++i];
+            
+            if (mode == "inline")
+                options.topologies = { Topology::Inline };
+            else if (mode == "threads")
+                options.topologies = { Topology::Threads };
+            else if (mode == "processes")
+                options.topologies = { Topology::Processes };
+            else if (mode != "all")
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--capacity" && i + 1 < argc)
+        {
+            options.capacityFrames = juce::jmax(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--seconds" && i + 1 < argc)
+        {
+            options.seconds = juce::jlimit(0.05, 60.0, std::atof(argv[++i]));
+        }
+        else if (arg == "--json")
+        {
+            options.json = true;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    if (!options.json)
+        printHeader();
+    
+    int caseNumber = 0;
+    int failures = 0;
+    
+    for (const auto topology : options.topologies)
+    {
+        for (const int numChannels : options.channelCounts)
+        {
+            for (const int blockSize : options.blockSizes)
+            {
+                BenchCase benchCase;
+                benchCase.blockSize = juce::jmin(blockSize, AudioSharedData::maxCapacityFrames / 2);
+                benchCase.numChannels = juce::jlimit(1, AudioSharedData::maxChannels, numChannels);
+                benchCase.capacityFrames = juce::nextPowerOfTwo(options.capacityFrames > 0
+                                                                ? juce::jmax(options.capacityFrames, benchCase.blockSize)
+                                                                : juce::jmax(4 * benchCase.blockSize, AudioSharedData::defaultCapacityFrames));
+                benchCase.capacityFrames = juce::jmin(benchCase.capacityFrames, AudioSharedData::maxCapacityFrames);
+                
+                // A fresh segment per case: the ring size and channel count are fixed when it is created
+                benchCase.segmentName = "BridgeBench-" + std::to_string(SharedMemoryManager::getProcessId())
+                                      + "-" + std::to_string(++caseNumber);
+                
+                BenchResult result;
+                
+                if (!runCase(topology, benchCase, options.seconds, result))
+                {
+                    std::cerr << getTopologyName(topology) << " " << benchCase.blockSize << " frames, "
+                              << benchCase.numChannels << " channels: failed" << std::endl;
+                    ++failures;
+                    continue;
+                }
+                
+                if (options.json)
+                    printJson(result);
+                else
+                    printRow(result);
+            }
+        }
+    }
+    
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,350 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include "JuceHeader.h"
+#include "SharedMemoryManager.h"
+
+// Live statistics of the bridge streams, read from the shared segment without touching it:
+// the segment is mapped read-only and every figure comes from counters and histograms that
+// the generator and the plugin keep there. Rates and percentiles are computed from the
+// difference between two samples, like vmstat
+
+// Command-line options
+struct StatOptions {
+    int streamId = -1;          // Only this stream (0-based); -1 shows every stream in use
+    int intervalMs = 1000;      // Time between samples
+    int count = 0;              // Samples to print (0 = until interrupted)
+    bool json = false;          // One JSON object per sample instead of the table
+};
+
+// One sample of a stream
+struct StreamSample {
+    SharedMemoryManager::StreamInfo info;
+    SharedMemoryManager::StreamCounters counters;
+    SharedMemoryManager::StreamTelemetry telemetry;
+};
+
+using Histogram = uint64_t[SharedMemoryManager::StreamTelemetry::numBuckets];
+
+// Upper bound of the bucket holding the given fraction of the values counted between two samples,
+// in microseconds (0 when nothing was counted)
+static double histogramPercentileUs(const Histogram& current, const Histogram& previous, double fraction)
+{
+    uint64_t total = 0;
+    
+    for (int bucket = 0; bucket < SharedMemoryManager::StreamTelemetry::numBuckets; ++bucket)
+        total += current[bucket] - previous[bucket];
+    
+    if (total == 0)
+        return 0.0;
+    
+    const double threshold = fraction * static_cast<double>(total);
+    uint64_t accumulated = 0;
+    
+    for (int bucket = 0; bucket < SharedMemoryManager::StreamTelemetry::numBuckets; ++bucket)
+    {
+        accumulated += current[bucket] - previous[bucket];
+        
+        if (static_cast<double>(accumulated) >= threshold)
+            return static_cast<double>(SharedMemoryManager::getTelemetryBucketLimitNs(bucket)) / 1000.0;
+    }
+    
+    return static_cast<double>(SharedMemoryManager::getTelemetryBucketLimitNs(SharedMemoryManager::StreamTelemetry::numBuckets - 1)) / 1000.0;
+}
+
+static std::string jsonString(const std::string& text)
+{
+    std::ostringstream out;
+    out << '"';
+    
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+            out << c;
+    }
+    
+    out << '"';
+    return out.str();
+}
+
+static void printJsonHistogram(std::ostream& out, const char* name, const Histogram& histogram)
+{
+    out << jsonString(name) << ":[";
+    
+    for (int bucket = 0; bucket < SharedMemoryManager::StreamTelemetry::numBuckets; ++bucket)
+        out << (bucket > 0 ? "," : "") << histogram[bucket];
+    
+    out << "]";
+}
+
+// Cumulative figures of every stream as one JSON line; consumers diff two lines themselves
+static void printJson(const std::vector<int>& streamIds, const std::vector<StreamSample>& samples, uint64_t timeNs)
+{
+    std::ostringstream out;
+    out << "{\"timeNs\":" << timeNs << ",\"bucketLimitsUs\":[";
+    
+    for (int bucket = 0; bucket < SharedMemoryManager::StreamTelemetry::numBuckets; ++bucket)
+        out << (bucket > 0 ? "," : "") << SharedMemoryManager::getTelemetryBucketLimitNs(bucket) / 1000;
+    
+    out << "],\"streams\":[";
+    
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const auto& sample = samples[i];
+        const auto& counters = sample.counters;
+        
+        out << (i > 0 ? "," : "") << "{\"stream\":" << streamIds[i] + 1
+            << ",\"name\":" << jsonString(sample.info.name)
+            << ",\"active\":" << (sample.info.active ? "true" : "false")
+            << ",\"consumerAttached\":" << (sample.info.consumerAttached ? "true" : "false")
+            << ",\"ownerPid\":" << sample.info.ownerPid
+            << ",\"channels\":" << sample.info.numChannels
+            << ",\"fill\":" << (counters.framesWritten - counters.framesRead)
+            << ",\"fillAtRead\":" << sample.telemetry.fillAtRead
+            << ",\"reads\":" << sample.telemetry.reads
+            << ",\"framesWritten\":" << counters.framesWritten
+            << ",\"framesRead\":" << counters.framesRead
+            << ",\"overruns\":" << counters.overruns
+            << ",\"droppedFrames\":" << counters.droppedFrames
+            << ",\"underruns\":" << counters.underruns
+            << ",\"concealedFrames\":" << counters.concealedFrames
+            << ",\"lostFrames\":" << counters.lostFrames
+            << ",\"repeatedFrames\":" << counters.repeatedFrames
+            << ",\"discardedFrames\":" << counters.discardedFrames << ",";
+        
+        printJsonHistogram(out, "renderTime", sample.telemetry.renderTime);
+        out << ",";
+        printJsonHistogram(out, "blockAge", sample.telemetry.blockAge);
+        out << ",";
+        printJsonHistogram(out, "callbackTime", sample.telemetry.callbackTime);
+        out << "}";
+    }
+    
+    out << "]}";
+    std::cout << out.str() << std::endl;
+}
+
+static void printTableHeader()
+{
+    std::cout << "stream   fill  write/s   read/s  under   over   lost    rep  concl"
+              << "  age50us  age99us  rnd99us   cb99us" << std::endl;
+}
+
+// One row per stream with the rates and events since the previous sample
+static void printTableRow(int streamId, const StreamSample& current, const StreamSample& previous, double seconds)
+{
+    const auto& now = current.counters;
+    const auto& before = previous.counters;
+    const auto& telemetry = current.telemetry;
+    const auto& telemetryBefore = previous.telemetry;
+    
+    std::cout << std::setw(6) << streamId + 1
+              << std::setw(7) << (now.framesWritten - now.framesRead)
+              << std::setw(9) << static_cast<uint64_t>((now.framesWritten - before.framesWritten) / seconds)
+              << std::setw(9) << static_cast<uint64_t>((now.framesRead - before.framesRead) / seconds)
+              << std::setw(7) << now.underruns - before.underruns
+              << std::setw(7) << now.overruns - before.overruns
+              << std::setw(7) << now.lostFrames - before.lostFrames
+              << std::setw(7) << now.repeatedFrames - before.repeatedFrames
+              << std::setw(7) << now.concealedFrames - before.concealedFrames
+              << std::fixed << std::setprecision(0)
+              << std::setw(9) << histogramPercentileUs(telemetry.blockAge, telemetryBefore.blockAge, 0.5)
+              << std::setw(9) << histogramPercentileUs(telemetry.blockAge, telemetryBefore.blockAge, 0.99)
+              << std::setw(9) << histogramPercentileUs(telemetry.renderTime, telemetryBefore.renderTime, 0.99)
+              << std::setw(9) << histogramPercentileUs(telemetry.callbackTime, telemetryBefore.callbackTime, 0.99)
+              << std::endl;
+}
+
+// Joins Chrome trace files written by TraceRecorder (one event per line) into one file. Every
+// process stamps its events with the shared monotonic clock and its own pid, so the merged
+// timeline shows the generator and the plugin side by side
+static int mergeTraces(const std::string& outputPath, const std::vector<std::string>& inputPaths)
+{
+    std::vector<std::string> events;
+    
+    for (const auto& inputPath : inputPaths)
+    {
+        std::ifstream input(inputPath);
+        
+        if (!input)
+        {
+            std::cerr << "Cannot read " << inputPath << std::endl;
+            return 1;
+        }
+        
+        std::string line;
+        
+        while (std::getline(input, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            
+            if (line.empty() || line.front() != '{' || line.rfind("{\"traceEvents\"", 0) == 0)
+                continue;
+            
+            if (line.back() == ',')
+                line.pop_back();
+            
+            events.push_back(line);
+        }
+    }
+    
+    std::ofstream output(outputPath);
+    output << "{\"traceEvents\":[\n";
+    
+    for (size_t i = 0; i < events.size(); ++i)
+        output << events[i] << (i + 1 < events.size() ? ",\n" : "\n");
+    
+    output << "],\"displayTimeUnit\":\"ns\"}\n";
+    
+    if (!output.good())
+    {
+        std::cerr << "Cannot write " << outputPath << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Merged " << events.size() << " events from " << inputPaths.size() << " files into " << outputPath << std::endl;
+    return 0;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: BridgeStat [--stream <id>] [--interval <ms>] [--count <samples>] [--json]" << std::endl;
+    std::cout << "       BridgeStat --merge-traces <output.json> <trace.json>..." << std::endl;
+    std::cout << "  --stream <id>        Show only this stream (default: every stream with a generator or a plugin)" << std::endl;
+    std::cout << "  --interval <ms>      Time between samples (default 1000)" << std::endl;
+    std::cout << "  --count <samples>    Number of samples to print (default: until interrupted; 1 with --json)" << std::endl;
+    std::cout << "  --json               Print the cumulative counters and histograms as one JSON object per sample" << std::endl;
+    std::cout << "Table columns are per-interval: frames per second written and read, underrun and overrun events," << std::endl;
+    std::cout << "frames lost, repeated and concealed, block age at read (p50, p99), generator render time (p99)" << std::endl;
+    std::cout << "and plugin callback time (p99); times are the upper bound of a power-of-two microsecond bucket" << std::endl;
+    std::cout << "--merge-traces joins the trace files of a BRIDGE_TRACE build of the generator and the plugin" << std::endl;
+    std::cout << "into one Chrome/Perfetto trace" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    StatOptions options;
+    bool countGiven = false;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        
+        if (arg == "--stream" && i + 1 < argc)
+        {
+            options.streamId = std::atoi(argv[++i]) - 1;
+        }
+        else if (arg == "--interval" && i + 1 < argc)
+        {
+            options.intervalMs = juce::jmax(10, std::atoi(argv[++i]));
+        }
+        else if (arg == "--count" && i + 1 < argc)
+        {
+            options.count = juce::jmax(0, std::atoi(argv[++i]));
+            countGiven = true;
+        }
+        else if (arg == "--json")
+        {
+            options.json = true;
+        }
+        else if (arg == "--merge-traces" && i + 2 < argc)
+        {
+            return mergeTraces(argv[i + 1], std::vector<std::string>(argv + i + 2, argv + argc));
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    if (options.json && !countGiven)
+        options.count = 1;
+    
+    // Read-only: never create the segment, never count as attached, never write
+    SharedMemoryManager::Config memoryConfig;
+    memoryConfig.readOnly = true;
+    
+    SharedMemoryManager sharedMemory;
+    
+    if (!sharedMemory.initialize(memoryConfig))
+    {
+        std::cerr << "No bridge shared memory found (start the plugin or a generator first)" << std::endl;
+        return 1;
+    }
+    
+    if (options.streamId >= sharedMemory.getMaxStreams())
+    {
+        std::cerr << "Stream " << options.streamId + 1 << " does not exist (1 to " << sharedMemory.getMaxStreams() << ")" << std::endl;
+        return 1;
+    }
+    
+    const auto takeSample = [&sharedMemory](int streamId)
+    {
+        StreamSample sample;
+        sample.info = sharedMemory.getStreamInfo(streamId);
+        sample.counters = sharedMemory.getStreamCounters(streamId);
+        sample.telemetry = sharedMemory.getStreamTelemetry(streamId);
+        return sample;
+    };
+    
+    std::vector<StreamSample> previous(static_cast<size_t>(sharedMemory.getMaxStreams()));
+    
+    for (int streamId = 0; streamId < sharedMemory.getMaxStreams(); ++streamId)
+        previous[static_cast<size_t>(streamId)] = takeSample(streamId);
+    
+    auto previousTime = std::chrono::steady_clock::now();
+    int printedRows = 0;
+    
+    // The table needs two samples for its rates; the JSON dump is cumulative and prints at once
+    for (int sampleNumber = 0; options.count == 0 || sampleNumber < options.count; ++sampleNumber)
+    {
+        if (!options.json || sampleNumber > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+        
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = juce::jmax(1.0e-3, std::chrono::duration<double>(now - previousTime).count());
+        previousTime = now;
+        
+        std::vector<int> streamIds;
+        std::vector<StreamSample> samples;
+        
+        for (int streamId = 0; streamId < sharedMemory.getMaxStreams(); ++streamId)
+        {
+            const auto sample = takeSample(streamId);
+            const bool inUse = sample.info.active || sample.info.consumerAttached;
+            
+            if (options.streamId == streamId || (options.streamId < 0 && inUse))
+            {
+                streamIds.push_back(streamId);
+                samples.push_back(sample);
+            }
+            
+            if (!options.json && !streamIds.empty() && streamIds.back() == streamId)
+            {
+                if (printedRows++ % 20 == 0)
+                    printTableHeader();
+                
+                printTableRow(streamId, sample, previous[static_cast<size_t>(streamId)], seconds);
+            }
+            
+            previous[static_cast<size_t>(streamId)] = sample;
+        }
+        
+        if (options.json)
+            printJson(streamIds, samples, SharedMemoryManager::getMonotonicNanoseconds());
+    }
+    
+    return 0;
+}
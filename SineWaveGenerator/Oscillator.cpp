@@ -0,0 +1,223 @@
+#include "Oscillator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // sin(pi * u) para u em [-0.5, 0.5]: série de Taylor até u^11 (erro < 1e-7 nessa faixa)
+    constexpr float sineCoefficients[] = {
+        3.1415926536e+00f,
+        -5.1677127800e+00f,
+        2.5501640399e+00f,
+        -5.9926452932e-01f,
+        8.2145886611e-02f,
+        -7.3704309457e-03f
+    };
+    
+    // Correção PolyBLEP de um degrau de -2 em t = 0 (t em ciclos, dt = incremento por amostra).
+    // As duas faixas são calculadas sempre e escolhidas por seleção, sem desvio
+    inline float polyBlep(float t, float dt, float inverseDt)
+    {
+        const float x = t * inverseDt;                  // antes da descontinuidade: t < dt
+        const float y = (t - 1.0f) * inverseDt;         // depois: t > 1 - dt
+        const float after = x + x - x * x - 1.0f;
+        const float before = y * y + y + y + 1.0f;
+        
+        return t < dt ? after : (t > 1.0f - dt ? before : 0.0f);
+    }
+}
+
+Oscillator::Oscillator()
+{
+    reset();
+}
+
+void Oscillator::setSampleRate(double newSampleRate)
+{
+    if (newSampleRate > 0.0)
+        sampleRate = newSampleRate;
+}
+
+void Oscillator::setFrequency(double newFrequency)
+{
+    frequency = juce::jmax(0.0, newFrequency);
+}
+
+void Oscillator::setWaveform(Waveform newWaveform)
+{
+    if (newWaveform != waveform)
+    {
+        waveform = newWaveform;
+        sweepPosition = 0.0;
+    }
+}
+
+void Oscillator::setSweep(double startFrequency, double endFrequency, double seconds)
+{
+    sweepStartFrequency = juce::jmax(1.0, startFrequency);
+    sweepEndFrequency = juce::jmax(1.0, endFrequency);
+    sweepSeconds = juce::jmax(0.1, seconds);
+    sweepPosition = 0.0;
+}
+
+void Oscillator::reset()
+{
+    phase = 0.0;
+    sweepPosition = 0.0;
+    
+    // Sementes distintas e não nulas por lane
+    uint32_t seed = 0x9E3779B9u;
+    
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        noiseState[i] = seed | 1u;
+    }
+}
+
+void Oscillator::render(float* output, int numSamples)
+{
+    // Acima de Nyquist o incremento é limitado: a forma de onda satura em vez de dobrar
+    const double maxIncrement = 0.5;
+    
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        const int numFrames = juce::jmin(chunkSize, numSamples - offset);
+        double startIncrement = juce::jmin(maxIncrement, frequency / sampleRate);
+        double endIncrement = startIncrement;
+        
+        if (waveform == Waveform::Sweep)
+        {
+            // Frequência exponencial no tempo, interpolada linearmente dentro do trecho
+            const double sweepLength = sweepSeconds * sampleRate;
+            const double ratio = std::log(sweepEndFrequency / sweepStartFrequency);
+            
+            startIncrement = juce::jmin(maxIncrement, sweepStartFrequency * std::exp(ratio * sweepPosition / sweepLength) / sampleRate);
+            endIncrement = juce::jmin(maxIncrement, sweepStartFrequency * std::exp(ratio * (sweepPosition + chunkSize) / sweepLength) / sampleRate);
+            
+            sweepPosition += numFrames;
+            
+            if (sweepPosition >= sweepLength)
+                sweepPosition = 0.0;
+        }
+        
+        computePhases(startIncrement, endIncrement);
+        
+        // Trechos completos vão direto para a saída; o último, parcial, passa pelo rascunho
+        float* destination = numFrames == chunkSize ? output + offset : scratch;
+        
+        switch (waveform)
+        {
+            case Waveform::Sine:
+            case Waveform::Sweep:   renderSine(destination); break;
+            case Waveform::Saw:     renderSaw(destination, startIncrement); break;
+            case Waveform::Square:  renderSquare(destination, startIncrement); break;
+            case Waveform::Noise:   renderNoise(destination); break;
+        }
+        
+        if (destination == scratch)
+            std::memcpy(output + offset, scratch, static_cast<size_t>(numFrames) * sizeof(float));
+        
+        // Avançar a fase pelas amostras realmente usadas, com a mesma fórmula de computePhases
+        const double slope = (endIncrement - startIncrement) / chunkSize;
+        phase += numFrames * startIncrement + slope * 0.5 * numFrames * (numFrames - 1);
+        phase -= std::floor(phase);
+    }
+}
+
+void Oscillator::computePhases(double startIncrement, double endIncrement)
+{
+    // Fase da amostra i com incremento variando linearmente de startIncrement a endIncrement;
+    // a parte inteira é descartada em double antes de reduzir para float
+    const double slope = (endIncrement - startIncrement) / chunkSize;
+    
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        const double index = static_cast<double>(i);
+        const double position = phase + index * startIncrement + slope * 0.5 * index * (index - 1.0);
+        phases[i] = static_cast<float>(position - static_cast<double>(static_cast<int>(position)));
+    }
+}
+
+void Oscillator::renderSine(float* output)
+{
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        // sin(2 pi p) = -sin(pi t) com t = 2p - 1 em [-1, 1); a simetria leva t para [-0.5, 0.5]
+        const float t = 2.0f * phases[i] - 1.0f;
+        const float u = std::max(std::min(t, 1.0f - t), -1.0f - t);
+        const float u2 = u * u;
+        
+        output[i] = -u * (sineCoefficients[0] + u2 * (sineCoefficients[1] + u2 * (sineCoefficients[2]
+                  + u2 * (sineCoefficients[3] + u2 * (sineCoefficients[4] + u2 * sineCoefficients[5])))));
+    }
+}
+
+void Oscillator::renderSaw(float* output, double increment)
+{
+    const float dt = static_cast<float>(juce::jmax(increment, 1.0e-9));
+    const float inverseDt = 1.0f / dt;
+    
+    for (int i = 0; i < chunkSize; ++i)
+        output[i] = 2.0f * phases[i] - 1.0f - polyBlep(phases[i], dt, inverseDt);
+}
+
+void Oscillator::renderSquare(float* output, double increment)
+{
+    const float dt = static_cast<float>(juce::jmax(increment, 1.0e-9));
+    const float inverseDt = 1.0f / dt;
+    
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        // Subida em p = 0 e descida em p = 0.5, cada uma com a sua correção
+        const float p = phases[i];
+        const float half = p < 0.5f ? p + 0.5f : p - 0.5f;
+        const float naive = p < 0.5f ? 1.0f : -1.0f;
+        
+        output[i] = naive + polyBlep(p, dt, inverseDt) - polyBlep(half, dt, inverseDt);
+    }
+}
+
+void Oscillator::renderNoise(float* output)
+{
+    // Um xorshift32 independente por lane: só deslocamentos e xor, vetorizável
+    for (int i = 0; i < chunkSize; ++i)
+    {
+        uint32_t state = noiseState[i];
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        noiseState[i] = state;
+        
+        output[i] = static_cast<float>(static_cast<int32_t>(state >> 8)) * (2.0f / 16777216.0f) - 1.0f;
+    }
+}
+
+const char* Oscillator::getWaveformName(Waveform waveform)
+{
+    switch (waveform)
+    {
+        case Waveform::Sine:    return "sine";
+        case Waveform::Saw:     return "saw";
+        case Waveform::Square:  return "square";
+        case Waveform::Noise:   return "noise";
+        case Waveform::Sweep:   return "sweep";
+    }
+    
+    return "?";
+}
+
+bool Oscillator::parseWaveform(const std::string& name, Waveform& result)
+{
+    for (auto candidate : { Waveform::Sine, Waveform::Saw, Waveform::Square, Waveform::Noise, Waveform::Sweep })
+    {
+        if (name == getWaveformName(candidate))
+        {
+            result = candidate;
+            return true;
+        }
+    }
+    
+    return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <cstdint>
+#include <string>
+
+// Oscilador de teste do gerador (senoide, dente de serra, quadrada, ruído e varredura)
+//
+// A fase fica em ciclos, em um acumulador double: não perde precisão em sessões
+// longas nem depende de um laço de "wrap". O bloco é renderizado em trechos de
+// chunkSize amostras; em cada trecho, as fases saem de uma fórmula fechada
+// (fase inicial + i * incremento) e os kernels são laços de tamanho fixo sem
+// dependência entre amostras, que o compilador vetoriza na largura do alvo
+// (4 lanes com SSE/NEON, 8 com AVX2, 16 com AVX-512; ver GENERATOR_NATIVE_ARCH
+// no CMake). A senoide usa um polinômio em vez de std::sin, com erro abaixo de
+// 1e-7, e dente de serra e quadrada são corrigidas com PolyBLEP para não criar
+// aliasing audível.
+class Oscillator
+{
+public:
+    enum class Waveform {
+        Sine,
+        Saw,
+        Square,
+        Noise,      // ruído branco uniforme
+        Sweep       // senoide com varredura logarítmica de frequência, repetida
+    };
+    
+    Oscillator();
+    
+    void setSampleRate(double newSampleRate);
+    void setFrequency(double newFrequency);
+    void setWaveform(Waveform newWaveform);
+    Waveform getWaveform() const { return waveform; }
+    
+    // Faixa e duração da varredura (modo Sweep)
+    void setSweep(double startFrequency, double endFrequency, double seconds);
+    
+    // Volta a fase e a varredura ao início
+    void reset();
+    
+    // Escreve numSamples amostras em output, continuando de onde o bloco anterior parou
+    void render(float* output, int numSamples);
+    
+    static const char* getWaveformName(Waveform waveform);
+    static bool parseWaveform(const std::string& name, Waveform& result);
+    
+    static constexpr int chunkSize = 64;
+
+private:
+    void computePhases(double startIncrement, double endIncrement);
+    void renderSine(float* output);
+    void renderSaw(float* output, double increment);
+    void renderSquare(float* output, double increment);
+    void renderNoise(float* output);
+    
+    Waveform waveform = Waveform::Sine;
+    double sampleRate = 44100.0;
+    double frequency = 440.0;
+    double phase = 0.0;                 // em ciclos, [0, 1)
+    
+    double sweepStartFrequency = 20.0;
+    double sweepEndFrequency = 20000.0;
+    double sweepSeconds = 10.0;
+    double sweepPosition = 0.0;         // amostras desde o início da varredura atual
+    
+    alignas(64) float phases[chunkSize];
+    alignas(64) float scratch[chunkSize];
+    alignas(64) uint32_t noiseState[chunkSize];     // um xorshift32 por lane
+};
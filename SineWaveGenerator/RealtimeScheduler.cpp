@@ -0,0 +1,184 @@
+#include "RealtimeScheduler.h"
+#include "SharedMemoryManager.h"
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <ctime>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+#endif
+
+#if JUCE_LINUX
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    
+    #ifndef SCHED_DEADLINE
+        #define SCHED_DEADLINE 6
+    #endif
+    
+    // Parâmetros de sched_setattr (o glibc só tem o wrapper nas versões recentes)
+    struct DeadlineAttributes {
+        uint32_t size;
+        uint32_t schedPolicy;
+        uint64_t schedFlags;
+        int32_t schedNice;
+        uint32_t schedPriority;
+        uint64_t schedRuntime;
+        uint64_t schedDeadline;
+        uint64_t schedPeriod;
+    };
+#endif
+
+bool RealtimeScheduler::lockProcessMemory()
+{
+#if JUCE_WINDOWS
+    std::cerr << "Memory locking is not supported on this platform; continuing without it" << std::endl;
+    return false;
+#else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        std::cerr << "mlockall failed (" << std::strerror(errno)
+                  << "); raise the memlock limit or grant CAP_IPC_LOCK. Continuing with pre-faulting only" << std::endl;
+        return false;
+    }
+    
+    return true;
+#endif
+}
+
+// SCHED_DEADLINE para a thread atual: runtimeNs de CPU garantidos a cada periodNs
+static bool setDeadlinePolicy(uint64_t periodNs, uint64_t runtimeNs)
+{
+#if JUCE_LINUX && defined(SYS_sched_setattr)
+    DeadlineAttributes attributes {};
+    attributes.size = sizeof(attributes);
+    attributes.schedPolicy = SCHED_DEADLINE;
+    attributes.schedRuntime = runtimeNs;
+    attributes.schedDeadline = periodNs;
+    attributes.schedPeriod = periodNs;
+    
+    if (syscall(SYS_sched_setattr, 0, &attributes, 0) == 0)
+        return true;
+    
+    std::cerr << "SCHED_DEADLINE unavailable (" << std::strerror(errno) << "); trying SCHED_FIFO" << std::endl;
+#else
+    juce::ignoreUnused(periodNs, runtimeNs);
+    std::cerr << "SCHED_DEADLINE is only available on Linux; trying SCHED_FIFO" << std::endl;
+#endif
+    return false;
+}
+
+static bool setFifoPolicy(int priority)
+{
+#if JUCE_WINDOWS
+    juce::ignoreUnused(priority);
+    
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        return true;
+    
+    std::cerr << "Could not raise the generator thread priority; running with the normal scheduler" << std::endl;
+    return false;
+#else
+    sched_param parameters {};
+    parameters.sched_priority = juce::jlimit(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), priority);
+    
+    const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+    
+    if (result == 0)
+        return true;
+    
+    std::cerr << "SCHED_FIFO unavailable (" << std::strerror(result)
+              << "); grant CAP_SYS_NICE or an rtprio limit. Running with the normal scheduler" << std::endl;
+    return false;
+#endif
+}
+
+static void pinCurrentThread(int cpu)
+{
+#if JUCE_LINUX
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    
+    if (result != 0)
+        std::cerr << "Could not pin the generator thread to CPU " << cpu << " (" << std::strerror(result) << ")" << std::endl;
+#elif JUCE_WINDOWS
+    if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8) || SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0)
+        std::cerr << "Could not pin the generator thread to CPU " << cpu << std::endl;
+#else
+    juce::ignoreUnused(cpu);
+    std::cerr << "CPU pinning is not supported on this platform" << std::endl;
+#endif
+}
+
+RealtimeScheduler::Policy RealtimeScheduler::configureCurrentThread(const Options& options, uint64_t periodNs, uint64_t runtimeNs)
+{
+    Policy result = Policy::Normal;
+    
+    if (options.policy == Policy::Deadline && setDeadlinePolicy(periodNs, runtimeNs))
+        result = Policy::Deadline;
+    else if (options.policy != Policy::Normal && setFifoPolicy(options.priority))
+        result = Policy::Fifo;
+    
+    // O kernel recusa afinidade restrita para SCHED_DEADLINE fora de um cpuset exclusivo
+    if (options.cpu >= 0)
+    {
+        if (result == Policy::Deadline)
+            std::cerr << "Ignoring --cpu with SCHED_DEADLINE (use an exclusive cpuset instead)" << std::endl;
+        else
+            pinCurrentThread(options.cpu);
+    }
+    
+    return result;
+}
+
+void RealtimeScheduler::prefaultStack()
+{
+    // O compilador não pode remover as escritas em um buffer volátil
+    volatile uint8_t stackPages[stackPrefaultBytes];
+    
+    for (int offset = 0; offset < stackPrefaultBytes; offset += 4096)
+        stackPages[offset] = 0;
+    
+    juce::ignoreUnused(stackPages[0]);
+}
+
+void RealtimeScheduler::sleepUntil(uint64_t deadlineNs)
+{
+#if JUCE_LINUX
+    // Mesmo relógio de SharedMemoryManager::getMonotonicNanoseconds
+    timespec deadline {};
+    deadline.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+    
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+    {
+    }
+#else
+    // Sem sono absoluto no relógio comum: dormir o que falta agora
+    const uint64_t now = SharedMemoryManager::getMonotonicNanoseconds();
+    
+    if (deadlineNs > now)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadlineNs - now));
+#endif
+}
+
+const char* RealtimeScheduler::getPolicyName(Policy policy)
+{
+    switch (policy)
+    {
+        case Policy::Normal:    return "normal";
+        case Policy::Fifo:      return "SCHED_FIFO";
+        case Policy::Deadline:  return "SCHED_DEADLINE";
+    }
+    
+    return "?";
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "JuceHeader.h"
+#include <cstdint>
+
+// Modo de tempo real da thread do gerador
+//
+// Nos nós de render, faltas de página e a preempção pelo escalonador comum são as
+// principais causas de blocos atrasados. Este módulo reúne o que o gerador faz para
+// evitá-las: trava a memória do processo (mlockall) e pré-carrega o segmento e a
+// pilha da thread, coloca a thread em SCHED_FIFO ou SCHED_DEADLINE, fixa-a em um
+// núcleo e dorme até instantes absolutos do relógio monotônico comum, para que o
+// erro de um despertar não se some ao do seguinte.
+//
+// Sem privilégios (CAP_SYS_NICE / CAP_IPC_LOCK ou limites rtprio / memlock), cada
+// passo que falha é avisado uma vez e o gerador segue com o que conseguiu: SCHED_DEADLINE
+// recua para SCHED_FIFO, e SCHED_FIFO para o escalonador normal.
+class RealtimeScheduler
+{
+public:
+    enum class Policy {
+        Normal,
+        Fifo,
+        Deadline
+    };
+    
+    struct Options {
+        Policy policy = Policy::Normal;
+        int priority = 70;          // prioridade SCHED_FIFO (1 a 99)
+        int cpu = -1;               // núcleo para fixar a thread (-1 = qualquer um)
+        bool lockMemory = false;    // mlockall e pré-carga das páginas
+    };
+    
+    // Trava as páginas atuais e futuras do processo; retorna false se não foi permitido
+    static bool lockProcessMemory();
+    
+    // Aplica política e afinidade à thread atual. periodNs e runtimeNs são o período e o
+    // orçamento de CPU por período usados por SCHED_DEADLINE. Retorna a política obtida
+    static Policy configureCurrentThread(const Options& options, uint64_t periodNs, uint64_t runtimeNs);
+    
+    // Toca as próximas páginas da pilha da thread atual, para que não faltem durante o render
+    static void prefaultStack();
+    
+    // Dorme até deadlineNs no relógio de SharedMemoryManager::getMonotonicNanoseconds
+    static void sleepUntil(uint64_t deadlineNs);
+    
+    static const char* getPolicyName(Policy policy);
+    
+    static constexpr int stackPrefaultBytes = 256 * 1024;
+};
@@ -1,12 +1,17 @@
 #include <iostream>
 #include <cmath>
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <vector>
 #include <string>
+#include <cstdlib>
 #include "JuceHeader.h"
 #include "SharedMemoryManager.h"
+#include "TraceRecorder.h"
 #include "AudioFileReader.h" // Incluir o novo cabeçalho
+#include "Oscillator.h"
+#include "RealtimeScheduler.h"
 
 // Enum para os modos de geração de áudio
 enum class AudioMode {
@@ -14,24 +19,60 @@ enum class AudioMode {
     File
 };
 
+// Command-line options
+struct GeneratorOptions {
+    SharedMemoryManager::Config memoryConfig;   // Ring layout and huge pages apply only if this process creates the
+                                                // segment; pre-faulting, locking and NUMA apply to our own mapping
+    int streamId = 0;                           // Slot in the shared stream directory (0-based)
+    std::string streamName = "SineWaveGenerator";
+    bool pullMode = false;                      // Render exactly the blocks the plugin requests
+    bool freeRunning = false;                   // Render on our own clock, like a separate audio device
+    double runSeconds = 0.0;                    // Start at once and exit after this long, without the menu (0 = menu)
+    Oscillator::Waveform waveform = Oscillator::Waveform::Sine;
+    double sweepSeconds = 10.0;                 // Duration of one 20 Hz to 20 kHz sweep
+    RealtimeScheduler::Options realtime;        // Scheduling policy, CPU pinning and memory locking
+};
+
 class SineWaveGenerator
 {
 public:
-    SineWaveGenerator() : 
+    explicit SineWaveGenerator(const GeneratorOptions& options = {}) : 
         frequency(440.0f), 
         isRunning(false), 
         sharedMemory(), 
         currentMode(AudioMode::Sine),
-        audioFileReader(std::make_unique<AudioFileReader>())
+        audioFileReader(std::make_unique<AudioFileReader>()),
+        pullMode(options.pullMode),
+        freeRunning(options.freeRunning),
+        realtime(options.realtime)
     {
+        oscillator.setWaveform(options.waveform);
+        oscillator.setSweep(20.0, 20000.0, options.sweepSeconds);
+        
         // Instance of SharedMemoryManager
-        if (!sharedMemory.initialize())
+        if (!sharedMemory.initialize(options.memoryConfig))
         {
             std::cerr << "Falha ao inicializar a memoria compartilhada" << std::endl;
             return;
         }
         
-        std::cout << "Memoria compartilhada inicializada com sucesso" << std::endl;
+        // Register our stream in the shared directory
+        if (!sharedMemory.registerStream(options.streamId, options.streamName, options.memoryConfig.numChannels))
+        {
+            std::cerr << "Failed to register stream " << (options.streamId + 1)
+                      << " (invalid or owned by another running generator)" << std::endl;
+            return;
+        }
+        
+        std::cout << "Memoria compartilhada inicializada com sucesso (stream " << (options.streamId + 1)
+                  << " \"" << options.streamName << "\", ring de "
+                  << sharedMemory.getCapacity() << " amostras, "
+                  << sharedMemory.getNumChannels() << " canais)" << std::endl;
+        
+        // Real-time mode: keep every page resident so the generator thread never takes a page
+        // fault (the ring was already pre-faulted by initialize; later allocations are locked by MCL_FUTURE)
+        if (realtime.lockMemory)
+            RealtimeScheduler::lockProcessMemory();
     }
     
     ~SineWaveGenerator()
@@ -57,6 +98,12 @@ public:
         if (isRunning.load())
             return;
         
+        if (sharedMemory.getCurrentStream() < 0)
+        {
+            std::cout << "No stream registered; cannot start generation." << std::endl;
+            return;
+        }
+        
         isRunning.store(true);
         
         // Indicates that the generator is active
@@ -64,8 +111,15 @@ public:
         
         generatorThread = std::thread(&SineWaveGenerator::run, this);
         
+        if (pullMode) {
+            std::cout << "Rendering on demand (pull mode)" << std::endl;
+        } else if (freeRunning) {
+            std::cout << "Rendering on the system clock (free-running mode)" << std::endl;
+        }
+        
         if (currentMode == AudioMode::Sine) {
-            std::cout << "Audio Generator Started (Senoid mode)" << std::endl;
+            std::cout << "Audio Generator Started (Senoid mode, "
+                      << Oscillator::getWaveformName(oscillator.getWaveform()) << ")" << std::endl;
         } else {
             std::cout << "Audio Generator Started (File mode)" << std::endl;
         }
@@ -81,6 +135,9 @@ public:
         // Indicates that the generator is no longer active
         sharedMemory.setGeneratorActive(false);
         
+        // Wake the generator thread if it is sleeping on the doorbell
+        sharedMemory.interruptWait();
+        
         if (generatorThread.joinable())
             generatorThread.join();
         
@@ -89,6 +146,20 @@ public:
         } else {
             std::cout << "Audio Generator Stopped (File mode)" << std::endl;
         }
+        
+        printStreamCounters();
+    }
+    
+    // Cumulative counters of the stream, kept in the shared segment by both sides
+    void printStreamCounters()
+    {
+        const auto counters = sharedMemory.getStreamCounters(sharedMemory.getCurrentStream());
+        
+        std::cout << "Frames written/read: " << counters.framesWritten << "/" << counters.framesRead
+                  << ", overruns: " << counters.overruns << " (" << counters.droppedFrames << " frames dropped)"
+                  << ", underruns: " << counters.underruns << " (" << counters.concealedFrames << " frames concealed)"
+                  << ", lost: " << counters.lostFrames << ", repeated: " << counters.repeatedFrames
+                  << ", discarded: " << counters.discardedFrames << std::endl;
     }
     
     bool loadAudioFile(const std::string& filePath)
@@ -103,6 +174,13 @@ public:
         {
             currentMode = AudioMode::File;
             
+            if (audioFileReader->getNumChannels() > sharedMemory.getNumChannels())
+            {
+                std::cout << "Warning: the file has " << audioFileReader->getNumChannels()
+                          << " channels but the shared ring carries " << sharedMemory.getNumChannels()
+                          << "; extra channels will not be sent." << std::endl;
+            }
+            
             // Updates the sample rate in the shared memory
             if (sharedMemory.isInitialized()) {
                 //sharedMemory.setSampleRate(audioFileReader->getSampleRate());
@@ -131,7 +209,7 @@ public:
     {
         return currentMode;
     }
-
+    
     void switchToFileMode()
     {
         if (isRunning.load())
@@ -149,114 +227,400 @@ public:
         return audioFileReader->isFileLoaded();
     }
     
+    bool isGenerating() const
+    {
+        return isRunning.load();
+    }
+
 private:
+    // Renders the next numSamples frames of the current source into the given channel pointers
+    // (usually a span of the shared ring returned by beginWrite) and returns how many were rendered
+    int renderAudio(float* const* channels, int numChannels, int numSamples)
+    {
+        if (numSamples <= 0)
+            return 0;
+        
+        if (currentMode == AudioMode::File && audioFileReader->isFileLoaded())
+        {
+            // Reads every channel of the file, without mixdown. The reader loops back to the
+            // beginning inside the block; it only comes up short when its background reads
+            // have not reached this part of the file yet, and then only what was read is published
+            return audioFileReader->getNextAudioBlock(channels, numChannels, numSamples);
+        }
+        else
+        {
+            // Senoid mode - uses the sample rate from the shared memory
+            double currentSampleRate = sharedMemory.getSampleRate();
+            
+            if (currentSampleRate <= 0)
+                currentSampleRate = 44100.0;  // Usar valor padrão se inválido
+            
+            // The oscillator keeps its own phase across blocks
+            float* output = channels[0];
+            oscillator.setSampleRate(currentSampleRate);
+            oscillator.setFrequency(frequency);
+            oscillator.render(output, numSamples);
+            
+            // Same tone on every channel
+            for (int ch = 1; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::copy(channels[ch], output, numSamples);
+        }
+        
+        return numSamples;
+    }
+    
+    // Renders straight into the reserved ring region (both spans when it wraps) and publishes
+    // the frames actually rendered; returns how many that was
+    int renderIntoRing(const SharedMemoryManager::WriteRegion& region)
+    {
+        BRIDGE_TRACE_SCOPE("render");
+        int rendered = renderAudio(region.first, region.numChannels, region.firstSize);
+        
+        // The second span only continues a complete first span
+        if (rendered == region.firstSize)
+            rendered += renderAudio(region.second, region.numChannels, region.secondSize);
+        
+        sharedMemory.commitWrite(rendered);
+        return rendered;
+    }
+    
+    // Follows host configuration changes published by the plugin: the change counter
+    // of the host control block tells us when to look at the sample rate again
+    void followHostConfiguration()
+    {
+        const auto hostControl = sharedMemory.getHostControl();
+        
+        if (hostControl.changeCount == lastHostChangeCount)
+            return;
+        
+        lastHostChangeCount = hostControl.changeCount;
+        
+        if (audioFileReader->isFileLoaded() && hostControl.sampleRate > 0.0
+            && hostControl.sampleRate != lastHostSampleRate)
+        {
+            audioFileReader->setTargetSampleRate(hostControl.sampleRate);
+        }
+        
+        lastHostSampleRate = hostControl.sampleRate;
+    }
+    
     void run()
     {
-        // Configurations
-        const int bufferSize = 4096;        // Audio buffer size
-        float phase = 0.0f;                 // Senoid phase
+        BRIDGE_TRACE_THREAD_NAME("generator");
         
-        std::vector<float> buffer(bufferSize);
+        configureRealtimeThread();
         
-        // Keep track of the continuous phase for the sine wave
-        float continuousPhase = 0.0f;
+        if (pullMode)
+            runPull();
+        else if (freeRunning)
+            runFreeRunning();
+        else
+            runPush();
+    }
+    
+    // Applies the real-time options to the generator thread. SCHED_DEADLINE gets half of
+    // one host block period (one render block before the host is known) per period
+    void configureRealtimeThread()
+    {
+        if (realtime.lockMemory)
+            RealtimeScheduler::prefaultStack();
+        
+        if (realtime.policy == RealtimeScheduler::Policy::Normal && realtime.cpu < 0)
+            return;
+        
+        double currentSampleRate = sharedMemory.getSampleRate();
         
-        // Timestamp for the last buffer sent
-        auto lastBufferTime = std::chrono::high_resolution_clock::now();
+        if (currentSampleRate <= 0)
+            currentSampleRate = 44100.0;
+        
+        const int hostBlockSize = sharedMemory.getHostBlockSize();
+        const int periodFrames = hostBlockSize > 0 ? hostBlockSize : juce::jmin(256, sharedMemory.getCapacity() / 2);
+        const auto periodNs = static_cast<uint64_t>(periodFrames * 1.0e9 / currentSampleRate);
+        
+        const auto policy = RealtimeScheduler::configureCurrentThread(realtime, periodNs, periodNs / 2);
+        std::cout << "Generator thread scheduling: " << RealtimeScheduler::getPolicyName(policy) << std::endl;
+    }
+    
+    // Push mode: keep the ring a few small blocks ahead of the host
+    void runPush()
+    {
+        // Configurations
+        const int ringCapacity = sharedMemory.getCapacity();
+        const int blockSize = juce::jmin(256, ringCapacity / 2);  // Render block size (frames)
+        const int minBlocksAhead = 2;       // Keep at least this many blocks queued in the ring (the plugin conceals underruns)
+        int publishedTargetFill = -1;
         
         while (isRunning.load())
         {
-            double currentSampleRate;
+            followHostConfiguration();
+            
+            // Keep the ring a few blocks ahead of the host, and at least two host blocks
+            const int targetFill = juce::jmin(ringCapacity,
+                                              juce::jmax(minBlocksAhead * blockSize,
+                                                         2 * sharedMemory.getHostBlockSize() + blockSize));
             
-            if (currentMode == AudioMode::File && audioFileReader->isFileLoaded())
+            // The level swings between targetFill - blockSize and targetFill; publish the middle
+            // so the plugin can report the bridge latency to the host
+            if (targetFill != publishedTargetFill)
             {
-                // Uses the sample rate from the audio file
-                //currentSampleRate = audioFileReader->getSampleRate();
-                
-
-                // Updates the sample rate in the shared memory
-                if (sharedMemory.isInitialized()) {
-                    //sharedMemory.setSampleRate(currentSampleRate);
-                    currentSampleRate = sharedMemory.getSampleRate();
-                }
-                
-                // Reads the audio data from the file
-                int samplesRead = audioFileReader->getNextAudioBlock(buffer.data(), bufferSize);
-                
-                // If the end of the file is reached, loop back to the beginning
-                if (samplesRead < bufferSize)
-                {
-                    std::fill(buffer.begin() + samplesRead, buffer.end(), 0.0f);
-                }
+                sharedMemory.setTargetFill(targetFill - blockSize / 2);
+                publishedTargetFill = targetFill;
             }
-            else
+            
+            // Render the next block directly into whatever part of it fits in the ring
+            if (sharedMemory.getNumSamplesAvailable() < targetFill)
             {
-                // Senoid mode - uses the sample rate from the shared memory
-                currentSampleRate = sharedMemory.getSampleRate();
-                
-                if (currentSampleRate <= 0)
-                    currentSampleRate = 44100.0;  // Usar valor padrão se inválido
+                const auto region = sharedMemory.beginWrite(blockSize);
                 
-                float currentFrequency = frequency;
-                
-                phase = continuousPhase; // Usar a fase continuada da iteração anterior
-                
-                for (int i = 0; i < bufferSize; ++i)
-                {
-                    buffer[i] = std::sin(phase);
-                    
-                    phase += 2.0f * float(juce::MathConstants<double>::pi) * currentFrequency / static_cast<float>(currentSampleRate);
-                    
-                    while (phase >= 2.0f * float(juce::MathConstants<double>::pi))
-                        phase -= 2.0f * float(juce::MathConstants<double>::pi);
-                }
-                
-                continuousPhase = phase;
+                // A short render means the file reader fell behind: give it a moment
+                // instead of spinning on the ring level
+                if (region.numFrames > 0 && renderIntoRing(region) < region.numFrames)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
             
-            double bufferDurationMs = (bufferSize * 1000.0) / currentSampleRate;
-            double targetRefreshMs = bufferDurationMs * 0.25; // 25% of the buffer duration
-            
-            bool written = false;
-            int attempts = 0;
-            const int maxAttempts = 10;
+            // Ring full or far enough ahead: sleep on the shared doorbell until the host
+            // drains it far enough (the plugin wakes us as soon as it reads past the mark)
+            if (sharedMemory.getNumSamplesAvailable() >= targetFill)
+            {
+                sharedMemory.waitForSpace(targetFill - blockSize, idleWaitTimeoutMs);
+                BRIDGE_TRACE_INSTANT("wake", sharedMemory.getNumSamplesAvailable());
+            }
+        }
+        
+        sharedMemory.setTargetFill(0);
+    }
+    
+    // Pull mode: render exactly the frames the plugin asked for, as soon as it asks
+    void runPull()
+    {
+        sharedMemory.setPullMode(true);
+        
+        while (isRunning.load())
+        {
+            // The demand is already limited to the free space, so the whole request fits
+            const int requested = sharedMemory.waitForDemand(idleWaitTimeoutMs);
+            BRIDGE_TRACE_INSTANT("wake", requested);
+            followHostConfiguration();
             
-            while (!written && attempts < maxAttempts && isRunning.load()) {
-                written = sharedMemory.writeAudioData(buffer.data(), bufferSize);
+            // The unmet part of a short render stays demanded, so waitForDemand would return
+            // at once: give the file reader a moment instead of spinning (it may be starved
+            // by this thread when it runs with a real-time policy)
+            if (requested > 0)
+            {
+                const auto region = sharedMemory.beginWrite(requested);
                 
-                if (!written) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1 << attempts));
-                    attempts++;
-                }
+                if (renderIntoRing(region) < region.numFrames)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
+        }
+        
+        sharedMemory.setPullMode(false);
+    }
+    
+    // Free-running mode: render one block per block period of the system clock, whatever the
+    // host does. The two clocks drift apart, so the plugin reads through its adaptive jitter
+    // buffer, which resamples slightly to keep the ring level steady
+    void runFreeRunning()
+    {
+        const int blockSize = juce::jmin(256, sharedMemory.getCapacity() / 2);  // Render block size (frames)
+        
+        sharedMemory.setFreeRunning(true);
+        
+        // Absolute deadlines on the shared monotonic clock, kept in double so the
+        // fractional nanoseconds of each block period do not accumulate as drift
+        double nextDeadlineNs = static_cast<double>(SharedMemoryManager::getMonotonicNanoseconds());
+        
+        while (isRunning.load())
+        {
+            followHostConfiguration();
             
-            auto now = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - lastBufferTime).count();
+            // A full ring drops the rest of the block, as an audio device overrun would;
+            // reporting it moves the source timeline on, so the plugin sees the gap
+            const auto region = sharedMemory.beginWrite(blockSize);
             
-            if (elapsed < targetRefreshMs) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(
-                    static_cast<int>(targetRefreshMs - elapsed)));
-            }
+            if (region.numFrames > 0)
+                renderIntoRing(region);
+            
+            if (region.numFrames < blockSize)
+                sharedMemory.reportOverrun(blockSize - region.numFrames);
+            
+            double currentSampleRate = sharedMemory.getSampleRate();
+            
+            if (currentSampleRate <= 0)
+                currentSampleRate = 44100.0;
+            
+            nextDeadlineNs += blockSize * 1.0e9 / currentSampleRate;
             
-            lastBufferTime = std::chrono::high_resolution_clock::now();
+            // After a long stall (debugger, suspended machine) start over instead of bursting to catch up
+            const auto now = static_cast<double>(SharedMemoryManager::getMonotonicNanoseconds());
+            
+            if (now - nextDeadlineNs > maxFreeRunLagMs * 1.0e6)
+                nextDeadlineNs = now;
+            else
+                RealtimeScheduler::sleepUntil(static_cast<uint64_t>(nextDeadlineNs));
+            
+            BRIDGE_TRACE_INSTANT("wake", sharedMemory.getNumSamplesAvailable());
         }
+        
+        sharedMemory.setFreeRunning(false);
     }
     
+    static constexpr int idleWaitTimeoutMs = 100;  // Upper bound on a doorbell wait, so host block size changes are picked up
+    static constexpr int maxFreeRunLagMs = 100;    // Free-running mode resynchronises its clock beyond this lag
+    
     float frequency;                    // Senoid frequency in Hz
     std::atomic<bool> isRunning;        // Flag to indicate if the generator is running
     std::thread generatorThread;        // Thread for audio generation
     SharedMemoryManager sharedMemory;   // Shared memory manager instance
     AudioMode currentMode;              // Current audio mode (sine or file)
     std::unique_ptr<AudioFileReader> audioFileReader; // Audio file reader instance
+    bool pullMode;                      // Render on demand instead of keeping the ring ahead
+    bool freeRunning;                   // Render on the system clock instead of following the host
+    RealtimeScheduler::Options realtime; // Real-time options for the generator thread
+    Oscillator oscillator;              // Test signal source for Senoid mode (generator thread)
+    uint32_t lastHostChangeCount = 0;   // Host control block version last seen by the generator thread
+    double lastHostSampleRate = 0.0;    // Sample rate the file reader was last retargeted to
 };
 
+static void printUsage()
+{
+    std::cout << "Usage: SineWaveGenerator [--stream <id>] [--name <text>] [--capacity <frames>] [--channels <count>] [--pull | --free-run] [--run <seconds>]" << std::endl;
+    std::cout << "                         [--waveform <name>] [--sweep <seconds>]" << std::endl;
+    std::cout << "                         [--realtime] [--rt-priority <1-99>] [--deadline] [--cpu <index>]" << std::endl;
+    std::cout << "                         [--huge-pages] [--lock-segment] [--numa-node <index>]" << std::endl;
+    std::cout << "  --stream <id>        Stream slot to register in the shared directory (1 to "
+              << AudioSharedData::defaultMaxStreams << "; default 1)" << std::endl;
+    std::cout << "  --name <text>        Stream name shown by the plugin (default SineWaveGenerator)" << std::endl;
+    std::cout << "  --capacity <frames>  Ring capacity used when this process creates the shared segment" << std::endl;
+    std::cout << "                       (rounded up to a power of two, "
+              << AudioSharedData::minCapacityFrames << " to " << AudioSharedData::maxCapacityFrames
+              << "; default " << AudioSharedData::defaultCapacityFrames << ")" << std::endl;
+    std::cout << "  --channels <count>   Planar channels carried by the ring when this process creates it" << std::endl;
+    std::cout << "                       (1 to " << AudioSharedData::maxChannels << "; default 2)" << std::endl;
+    std::cout << "  --pull               Render exactly the blocks the plugin requests (about one host" << std::endl;
+    std::cout << "                       block of latency) instead of keeping the ring ahead" << std::endl;
+    std::cout << "  --free-run           Render on the system clock, like a separate audio device; the plugin" << std::endl;
+    std::cout << "                       compensates the clock drift with its adaptive jitter buffer" << std::endl;
+    std::cout << "  --run <seconds>      Start generating at once and exit after this many seconds, without" << std::endl;
+    std::cout << "                       the interactive menu (scripted runs such as BridgeHarness)" << std::endl;
+    std::cout << "  --waveform <name>    Senoid mode signal: sine, saw, square, noise or sweep (default sine)" << std::endl;
+    std::cout << "  --sweep <seconds>    Duration of one 20 Hz to 20 kHz logarithmic sweep (default 10)" << std::endl;
+    std::cout << "  --realtime           Lock memory (mlockall), pre-fault the ring and run the generator" << std::endl;
+    std::cout << "                       thread with SCHED_FIFO; steps without privileges are skipped" << std::endl;
+    std::cout << "  --rt-priority <n>    SCHED_FIFO priority for --realtime (1 to 99; default 70)" << std::endl;
+    std::cout << "  --deadline           Like --realtime, with SCHED_DEADLINE (Linux; falls back to SCHED_FIFO)" << std::endl;
+    std::cout << "  --cpu <index>        Pin the generator thread to this CPU" << std::endl;
+    std::cout << "  --huge-pages         Create the shared segment on hugetlbfs (/dev/hugepages), or ask for" << std::endl;
+    std::cout << "                       transparent huge pages when no huge page is reserved (Linux)" << std::endl;
+    std::cout << "  --lock-segment       Lock the shared segment in memory (mlock) without locking the whole process" << std::endl;
+    std::cout << "  --numa-node <index>  Place the shared segment on this NUMA node (Linux; use the node of the" << std::endl;
+    std::cout << "                       CPU given to --cpu and of the host's audio thread)" << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
     std::cout << "Application for Low Latency VST Plugin Audio Generator" << std::endl;
     std::cout << "=====================================================================" << std::endl;
     
-    SineWaveGenerator generator;
+    GeneratorOptions options;
+    
+    // Instrumentation mode (BRIDGE_TRACE): reserve the event rings before any thread starts
+    BRIDGE_TRACE_INITIALISE("SineWaveGenerator");
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        
+        if (arg == "--stream" && i + 1 < argc)
+        {
+            options.streamId = std::atoi(argv[++i]) - 1;
+        }
+        else if (arg == "--name" && i + 1 < argc)
+        {
+            options.streamName = argv[++i];
+        }
+        else if (arg == "--capacity" && i + 1 < argc)
+        {
+            options.memoryConfig.capacityFrames = std::atoi(argv[++i]);
+        }
+        else if (arg == "--channels" && i + 1 < argc)
+        {
+            options.memoryConfig.numChannels = std::atoi(argv[++i]);
+        }
+        else if (arg == "--pull")
+        {
+            options.pullMode = true;
+        }
+        else if (arg == "--free-run")
+        {
+            options.freeRunning = true;
+        }
+        else if (arg == "--run" && i + 1 < argc)
+        {
+            options.runSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--waveform" && i + 1 < argc && Oscillator::parseWaveform(argv[i + 1], options.waveform))
+        {
+            ++i;
+        }
+        else if (arg == "--sweep" && i + 1 < argc)
+        {
+            options.sweepSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--realtime" || (arg == "--rt-priority" && i + 1 < argc))
+        {
+            if (arg == "--rt-priority")
+                options.realtime.priority = juce::jlimit(1, 99, std::atoi(argv[++i]));
+            
+            options.realtime.lockMemory = true;
+            
+            if (options.realtime.policy == RealtimeScheduler::Policy::Normal)
+                options.realtime.policy = RealtimeScheduler::Policy::Fifo;
+        }
+        else if (arg == "--deadline")
+        {
+            options.realtime.lockMemory = true;
+            options.realtime.policy = RealtimeScheduler::Policy::Deadline;
+        }
+        else if (arg == "--cpu" && i + 1 < argc)
+        {
+            options.realtime.cpu = juce::jmax(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--huge-pages")
+        {
+            options.memoryConfig.hugePages = true;
+        }
+        else if (arg == "--lock-segment")
+        {
+            options.memoryConfig.lockPages = true;
+        }
+        else if (arg == "--numa-node" && i + 1 < argc)
+        {
+            options.memoryConfig.numaNode = juce::jmax(0, std::atoi(argv[++i]));
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    SineWaveGenerator generator(options);
+    
+    // Headless run: no menu, generate for the requested time and exit
+    if (options.runSeconds > 0.0)
+    {
+        generator.start();
+        
+        if (!generator.isGenerating())
+            return 1;
+        
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.runSeconds));
+        generator.stop();
+        
+        BRIDGE_TRACE_WRITE();
+        return 0;
+    }
     
     // Menu interativo
     bool quit = false;
@@ -297,11 +661,11 @@ int main(int argc, char* argv[])
             case 1: 
                 generator.start();
                 break;
-                
+            
             case 2: 
                 generator.stop();
                 break;
-                
+            
             case 3: 
             {
                 if (generator.getCurrentMode() == AudioMode::Sine) {
@@ -317,7 +681,7 @@ int main(int argc, char* argv[])
                     std::cout << "This command is not available in file mode." << std::endl;        }
                 break;
             }
-                
+            
             case 4: 
             {
                 std::string filePath;
@@ -330,7 +694,7 @@ int main(int argc, char* argv[])
                 }
                 break;
             }
-                
+            
             case 5: 
             {
                 if (generator.getCurrentMode() == AudioMode::Sine) {
@@ -348,12 +712,15 @@ int main(int argc, char* argv[])
                 }
                 break;
             }
-                
+            
             case 6: 
                 generator.stop();
                 quit = true;
-                break;
                 
+                // The generator thread has stopped: write the trace of this session
+                BRIDGE_TRACE_WRITE();
+                break;
+            
             default:
                 std::cout << "Invalid command!" << std::endl;
                 break;
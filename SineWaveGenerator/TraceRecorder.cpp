@@ -0,0 +1,277 @@
+#include "TraceRecorder.h"
+#include "SharedMemoryManager.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct TraceEvent {
+        uint64_t timeNs = 0;
+        const char* name = nullptr;
+        int64_t value = 0;
+        int32_t track = 0;
+        TraceRecorder::EventType type = TraceRecorder::EventType::Instant;
+    };
+    
+    // Ring de uma thread: só ela escreve; writeIndex conta todos os eventos já gravados
+    struct ThreadBuffer {
+        std::atomic<uint64_t> writeIndex { 0 };
+        std::atomic<bool> claimed { false };
+        char name[32] = {};
+        std::vector<TraceEvent> events;
+    };
+    
+    struct TraceState {
+        std::string processName;
+        uint64_t mask = 0;
+        std::unique_ptr<ThreadBuffer[]> buffers;
+        int numBuffers = 0;
+        std::atomic<int> nextBuffer { 0 };
+        std::atomic<uint64_t> droppedEvents { 0 };   // de threads que ficaram sem ring
+        std::atomic<bool> active { false };
+        std::atomic<int> users { 0 };       // initialise() sem o finish() correspondente
+    };
+    
+    TraceState& getState()
+    {
+        static TraceState state;
+        return state;
+    }
+    
+    // Ring da thread atual: -1 antes de reivindicar, -2 se não sobrou ring para ela
+    thread_local int threadBufferIndex = -1;
+    thread_local int32_t currentTrack = 0;
+    
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        auto& state = getState();
+        
+        if (threadBufferIndex == -1)
+        {
+            const int index = state.nextBuffer.fetch_add(1, std::memory_order_relaxed);
+            threadBufferIndex = index < state.numBuffers ? index : -2;
+            
+            if (threadBufferIndex >= 0)
+                state.buffers[static_cast<size_t>(threadBufferIndex)].claimed.store(true, std::memory_order_release);
+        }
+        
+        return threadBufferIndex >= 0 ? &state.buffers[static_cast<size_t>(threadBufferIndex)] : nullptr;
+    }
+    
+    void writeJsonString(std::ostream& out, const char* text)
+    {
+        out << '"';
+        
+        for (const char* c = text; *c != 0; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                out << *c;
+        }
+        
+        out << '"';
+    }
+}
+
+void TraceRecorder::initialise(const char* processName, int eventsPerThread)
+{
+    auto& state = getState();
+    
+    if (state.users.fetch_add(1, std::memory_order_acq_rel) > 0)
+        return;
+    
+    if (state.buffers == nullptr)
+    {
+        const int capacity = juce::nextPowerOfTwo(juce::jmax(1024, eventsPerThread));
+        
+        state.processName = processName;
+        state.mask = static_cast<uint64_t>(capacity - 1);
+        state.numBuffers = static_cast<int>(std::thread::hardware_concurrency()) + extraThreads;
+        state.buffers.reset(new ThreadBuffer[static_cast<size_t>(state.numBuffers)]);
+        
+        for (int i = 0; i < state.numBuffers; ++i)
+            state.buffers[static_cast<size_t>(i)].events.resize(static_cast<size_t>(capacity));
+    }
+    else
+    {
+        // Nova sessão depois de um finish(): os rings (e as threads que já os têm) continuam,
+        // só os eventos da sessão anterior são descartados
+        for (int i = 0; i < state.numBuffers; ++i)
+            state.buffers[static_cast<size_t>(i)].writeIndex.store(0, std::memory_order_relaxed);
+        
+        state.droppedEvents.store(0, std::memory_order_relaxed);
+    }
+    
+    state.active.store(true, std::memory_order_release);
+}
+
+bool TraceRecorder::finish(const std::string& path)
+{
+    auto& state = getState();
+    
+    if (state.users.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return false;
+    
+    // Nenhum usuário restante: parar a gravação antes de ler os rings
+    state.active.store(false, std::memory_order_release);
+    return writeChromeTrace(path);
+}
+
+bool TraceRecorder::isActive()
+{
+    return getState().active.load(std::memory_order_acquire);
+}
+
+void TraceRecorder::setThreadName(const char* name)
+{
+    if (!isActive())
+        return;
+    
+    auto* buffer = getThreadBuffer();
+    
+    if (buffer == nullptr || buffer->name[0] != 0)
+        return;
+    
+    std::strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+}
+
+void TraceRecorder::setTrack(int track) noexcept
+{
+    currentTrack = static_cast<int32_t>(track);
+}
+
+void TraceRecorder::record(EventType type, const char* name, int64_t value) noexcept
+{
+    auto& state = getState();
+    
+    if (!state.active.load(std::memory_order_acquire))
+        return;
+    
+    auto* buffer = getThreadBuffer();
+    
+    if (buffer == nullptr)
+    {
+        state.droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    const uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+    auto& event = buffer->events[static_cast<size_t>(index & state.mask)];
+    
+    event.timeNs = SharedMemoryManager::getMonotonicNanoseconds();
+    event.name = name;
+    event.value = value;
+    event.track = currentTrack;
+    event.type = type;
+    
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::writeChromeTrace(const std::string& path)
+{
+    auto& state = getState();
+    
+    if (state.buffers == nullptr)
+        return false;
+    
+    std::ofstream out(path);
+    
+    if (!out)
+        return false;
+    
+    const int pid = SharedMemoryManager::getProcessId();
+    
+    // Um evento por linha: BridgeStat --merge-traces junta arquivos linha a linha
+    out << "{\"traceEvents\":[\n";
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":";
+    writeJsonString(out, state.processName.c_str());
+    out << "}}";
+    
+    const uint64_t droppedEvents = state.droppedEvents.load(std::memory_order_relaxed);
+    
+    if (droppedEvents > 0)
+    {
+        const int unclaimedThreads = state.nextBuffer.load(std::memory_order_relaxed) - state.numBuffers;
+        
+        out << ",\n{\"ph\":\"M\",\"name\":\"process_labels\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"labels\":\""
+            << droppedEvents << " events lost: " << unclaimedThreads << " threads without a trace ring\"}}";
+    }
+    
+    for (int thread = 0; thread < state.numBuffers; ++thread)
+    {
+        auto& buffer = state.buffers[static_cast<size_t>(thread)];
+        
+        if (!buffer.claimed.load(std::memory_order_acquire))
+            continue;
+        
+        // Uma linha do trace por faixa de cada thread: tid = faixa * numBuffers + thread
+        std::vector<int32_t> namedTracks;
+        
+        // Só os últimos capacity eventos ainda estão no ring
+        const uint64_t end = buffer.writeIndex.load(std::memory_order_acquire);
+        const uint64_t capacity = state.mask + 1;
+        const uint64_t start = end > capacity ? end - capacity : 0;
+        
+        for (uint64_t index = start; index < end; ++index)
+        {
+            const auto& event = buffer.events[static_cast<size_t>(index & state.mask)];
+            static const char* const phases[] = { "B", "E", "i", "C" };
+            const int64_t tid = static_cast<int64_t>(event.track) * state.numBuffers + thread;
+            
+            if (std::find(namedTracks.begin(), namedTracks.end(), event.track) == namedTracks.end())
+            {
+                namedTracks.push_back(event.track);
+                
+                std::string laneName = buffer.name[0] != 0 ? std::string(buffer.name) : "thread " + std::to_string(thread);
+                
+                if (event.track != 0)
+                    laneName += " #" + std::to_string(event.track);
+                
+                out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+                writeJsonString(out, laneName.c_str());
+                out << "}}";
+            }
+            
+            // O formato usa microssegundos; as frações preservam a resolução em ns
+            out << ",\n{\"ph\":\"" << phases[static_cast<int>(event.type)] << "\",\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << event.timeNs / 1000 << "."
+                << std::setw(3) << std::setfill('0') << event.timeNs % 1000 << std::setfill(' ');
+            
+            if (event.type == EventType::Instant)
+                out << ",\"s\":\"t\",\"args\":{\"value\":" << event.value << "}";
+            else if (event.type == EventType::Counter)
+                out << ",\"args\":{\"value\":" << event.value << "}";
+            
+            out << "}";
+        }
+    }
+    
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return out.good();
+}
+
+std::string TraceRecorder::getDefaultTracePath()
+{
+    const char* directory = std::getenv("BRIDGE_TRACE_DIR");
+    std::string path = directory != nullptr && directory[0] != 0
+                     ? std::string(directory)
+                     : juce::File::getSpecialLocation(juce::File::tempDirectory).getFullPathName().toStdString();
+    
+    std::string name = getState().processName;
+    
+    for (auto& c : name)
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+            c = '-';
+    
+    return path + "/bridge-trace-" + name + "-" + std::to_string(SharedMemoryManager::getProcessId()) + ".json";
+}